@@ -2,14 +2,25 @@
 
 set -e
 
-files=main.c
-flags="-Werror=declaration-after-statement -std=c99"
+files="vm.c main.c"
+flags="-Werror=declaration-after-statement -std=c99 -pthread"
 outfile=vm
 
-if [[ $1 = "prod" ]]; then
+if [[ $1 = "lib" ]]; then
+    # Everything but the vm_* API is hidden, and localized in the static
+    # library too so the interpreter's symbols cannot clash with the host's.
+    flags+=" -Wall -Wextra -Werror -pedantic -O3 -fPIC -fvisibility=hidden"
+    gcc $flags -c -o vm.o vm.c
+    gcc -shared -s -o libvm.so vm.o
+    objcopy --localize-hidden --strip-unneeded vm.o
+    ar rcs libvm.a vm.o
+    rm vm.o
+    exit
+elif [[ $1 = "prod" ]]; then
     flags+=" -Wall -Wextra -Werror -pedantic -s -O3"
 elif [[ $1 = "test" ]]; then
     flags+=" -D TEST"
+    files=vm.c
 else
     flags+=" -ggdb"
 fi
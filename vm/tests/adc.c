@@ -0,0 +1,96 @@
+struct adc_test_case {
+    char *title;
+    uint16_t a;
+    uint16_t b;
+    int carry;
+    uint16_t expect;
+    int cf;
+    int of;
+    int zf;
+};
+
+struct adc_test_case adc_cases[] = {
+    {
+        .title = "without carry",
+        .a = 1,
+        .b = 2,
+        .carry = 0,
+        .expect = 3,
+        .cf = 0,
+        .of = 0,
+        .zf = 0
+    },
+    {
+        .title = "with carry",
+        .a = 1,
+        .b = 2,
+        .carry = 1,
+        .expect = 4,
+        .cf = 0,
+        .of = 0,
+        .zf = 0
+    },
+    {
+        .title = "carry in carries out",
+        .a = 0xffff,
+        .b = 0,
+        .carry = 1,
+        .expect = 0,
+        .cf = 1,
+        .of = 0,
+        .zf = 1
+    },
+    {
+        .title = "signed overflow",
+        .a = 0x7fff,
+        .b = 0,
+        .carry = 1,
+        .expect = 0x8000,
+        .cf = 0,
+        .of = 1,
+        .zf = 0
+    }
+};
+
+void test_adc()
+{
+    printf("test_adc\n");
+
+    for (int i = 0; i < arrlen(adc_cases); ++i) {
+        struct adc_test_case tcase = adc_cases[i];
+
+        printf("    %s\n", tcase.title);
+        reset_vm();
+
+        vm->flags[CF] = tcase.carry;
+        vm->regfile[R10] = tcase.a;
+        vm->regfile[R11] = tcase.b;
+        adc(R11, R10);
+        halt();
+
+        vm->pc = 0;
+        vm_start(vm);
+
+        assert(vm->regfile[R10] == tcase.expect);
+        assert(vm->flags[CF] == tcase.cf);
+        assert(vm->flags[OF] == tcase.of);
+        assert(vm->flags[ZF] == tcase.zf);
+    }
+
+    printf("    chains a 32-bit addition\n");
+    reset_vm();
+
+    vm->regfile[R0] = 0xffff;
+    vm->regfile[R1] = 0x0001;
+    vm->regfile[R2] = 0x0001;
+    vm->regfile[R3] = 0x0000;
+    addf(R2, R0);
+    adc(R3, R1);
+    halt();
+
+    vm->pc = 0;
+    vm_start(vm);
+
+    assert(vm->regfile[R0] == 0x0000);
+    assert(vm->regfile[R1] == 0x0002);
+}
@@ -0,0 +1,79 @@
+struct adcb_test_case {
+    char *title;
+    uint16_t a;
+    uint16_t b;
+    int carry;
+    uint16_t expect;
+    int cf;
+    int of;
+    int zf;
+};
+
+struct adcb_test_case adcb_cases[] = {
+    {
+        .title = "without carry",
+        .a = 0xab01,
+        .b = 0x02,
+        .carry = 0,
+        .expect = 0xab03,
+        .cf = 0,
+        .of = 0,
+        .zf = 0
+    },
+    {
+        .title = "with carry",
+        .a = 0xab01,
+        .b = 0x02,
+        .carry = 1,
+        .expect = 0xab04,
+        .cf = 0,
+        .of = 0,
+        .zf = 0
+    },
+    {
+        .title = "carry in carries out",
+        .a = 0xabff,
+        .b = 0x00,
+        .carry = 1,
+        .expect = 0xab00,
+        .cf = 1,
+        .of = 0,
+        .zf = 1
+    },
+    {
+        .title = "signed overflow",
+        .a = 0xab7f,
+        .b = 0x00,
+        .carry = 1,
+        .expect = 0xab80,
+        .cf = 0,
+        .of = 1,
+        .zf = 0
+    }
+};
+
+void test_adcb()
+{
+    printf("test_adcb\n");
+
+    for (int i = 0; i < arrlen(adcb_cases); ++i) {
+        struct adcb_test_case tcase = adcb_cases[i];
+
+        printf("    %s\n", tcase.title);
+        reset_vm();
+
+        vm->flags[CF] = tcase.carry;
+        vm->regfile[R10] = tcase.a;
+        vm->regfile[R11] = tcase.b;
+        adcb(R11, R10);
+        halt();
+
+        vm->pc = 0;
+        vm_start(vm);
+
+        assert(vm->regfile[R10] == tcase.expect);
+        assert(vm->flags[CF] == tcase.cf);
+        assert(vm->flags[OF] == tcase.of);
+        assert(vm->flags[ZF] == tcase.zf);
+    }
+}
@@ -0,0 +1,79 @@
+struct addf_test_case {
+    char *title;
+    uint16_t a;
+    uint16_t b;
+    int carry;
+    uint16_t expect;
+    int cf;
+    int of;
+    int zf;
+};
+
+struct addf_test_case addf_cases[] = {
+    {
+        .title = "add",
+        .a = 1,
+        .b = 2,
+        .carry = 0,
+        .expect = 3,
+        .cf = 0,
+        .of = 0,
+        .zf = 0
+    },
+    {
+        .title = "ignores carry in",
+        .a = 1,
+        .b = 2,
+        .carry = 1,
+        .expect = 3,
+        .cf = 0,
+        .of = 0,
+        .zf = 0
+    },
+    {
+        .title = "carry out",
+        .a = 0xffff,
+        .b = 1,
+        .carry = 0,
+        .expect = 0,
+        .cf = 1,
+        .of = 0,
+        .zf = 1
+    },
+    {
+        .title = "signed overflow",
+        .a = 0x7fff,
+        .b = 1,
+        .carry = 0,
+        .expect = 0x8000,
+        .cf = 0,
+        .of = 1,
+        .zf = 0
+    }
+};
+
+void test_addf()
+{
+    printf("test_addf\n");
+
+    for (int i = 0; i < arrlen(addf_cases); ++i) {
+        struct addf_test_case tcase = addf_cases[i];
+
+        printf("    %s\n", tcase.title);
+        reset_vm();
+
+        vm->flags[CF] = tcase.carry;
+        vm->regfile[R10] = tcase.a;
+        vm->regfile[R11] = tcase.b;
+        addf(R11, R10);
+        halt();
+
+        vm->pc = 0;
+        vm_start(vm);
+
+        assert(vm->regfile[R10] == tcase.expect);
+        assert(vm->flags[CF] == tcase.cf);
+        assert(vm->flags[OF] == tcase.of);
+        assert(vm->flags[ZF] == tcase.zf);
+    }
+}
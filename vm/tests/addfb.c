@@ -0,0 +1,79 @@
+struct addfb_test_case {
+    char *title;
+    uint16_t a;
+    uint16_t b;
+    int carry;
+    uint16_t expect;
+    int cf;
+    int of;
+    int zf;
+};
+
+struct addfb_test_case addfb_cases[] = {
+    {
+        .title = "add",
+        .a = 0xab01,
+        .b = 0x02,
+        .carry = 0,
+        .expect = 0xab03,
+        .cf = 0,
+        .of = 0,
+        .zf = 0
+    },
+    {
+        .title = "ignores carry in",
+        .a = 0xab01,
+        .b = 0x02,
+        .carry = 1,
+        .expect = 0xab03,
+        .cf = 0,
+        .of = 0,
+        .zf = 0
+    },
+    {
+        .title = "carry out",
+        .a = 0xabff,
+        .b = 0x01,
+        .carry = 0,
+        .expect = 0xab00,
+        .cf = 1,
+        .of = 0,
+        .zf = 1
+    },
+    {
+        .title = "signed overflow",
+        .a = 0xab7f,
+        .b = 0x01,
+        .carry = 0,
+        .expect = 0xab80,
+        .cf = 0,
+        .of = 1,
+        .zf = 0
+    }
+};
+
+void test_addfb()
+{
+    printf("test_addfb\n");
+
+    for (int i = 0; i < arrlen(addfb_cases); ++i) {
+        struct addfb_test_case tcase = addfb_cases[i];
+
+        printf("    %s\n", tcase.title);
+        reset_vm();
+
+        vm->flags[CF] = tcase.carry;
+        vm->regfile[R10] = tcase.a;
+        vm->regfile[R11] = tcase.b;
+        addfb(R11, R10);
+        halt();
+
+        vm->pc = 0;
+        vm_start(vm);
+
+        assert(vm->regfile[R10] == tcase.expect);
+        assert(vm->flags[CF] == tcase.cf);
+        assert(vm->flags[OF] == tcase.of);
+        assert(vm->flags[ZF] == tcase.zf);
+    }
+}
@@ -0,0 +1,25 @@
+
+void test_addfbi()
+{
+    printf("test_addfbi\n");
+
+    for (int i = 0; i < arrlen(addfb_cases); ++i) {
+        struct addfb_test_case tcase = addfb_cases[i];
+
+        printf("    %s\n", tcase.title);
+        reset_vm();
+
+        vm->flags[CF] = tcase.carry;
+        vm->regfile[R10] = tcase.a;
+        addfbi(tcase.b, R10);
+        halt();
+
+        vm->pc = 0;
+        vm_start(vm);
+
+        assert(vm->regfile[R10] == tcase.expect);
+        assert(vm->flags[CF] == tcase.cf);
+        assert(vm->flags[OF] == tcase.of);
+        assert(vm->flags[ZF] == tcase.zf);
+    }
+}
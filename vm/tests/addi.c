@@ -8,14 +8,14 @@ void test_addi()
         printf("    %s\n", tcase.title);
         reset_vm();
 
-        regfile[R10] = tcase.a;
+        vm->regfile[R10] = tcase.a;
         addi(tcase.b, R10);
         halt();
 
-        pc = 0;
-        vm_start();
+        vm->pc = 0;
+        vm_start(vm);
 
-        assert(regfile[R10] == tcase.expect);
+        assert(vm->regfile[R10] == tcase.expect);
     }
 }
 
@@ -3,12 +3,12 @@ void test_andbi()
     printf("test_andbi\n");
     reset_vm();
 
-    regfile[R10] = 0xabcd;
+    vm->regfile[R10] = 0xabcd;
     andbi(0x0f, R10);
     halt();
 
-    pc = 0;
-    vm_start();
+    vm->pc = 0;
+    vm_start(vm);
 
-    assert(regfile[R10] == 0xab0d);
+    assert(vm->regfile[R10] == 0xab0d);
 }
@@ -0,0 +1,73 @@
+void test_bank()
+{
+    printf("test_bank\n");
+
+    printf("    switches the window between banks\n");
+    reset_vm();
+
+    write_word(vm, 0x1111, BANK_WINDOW);
+
+    movi(1, R10);
+    bank(R10);
+    movi(0xabcd, R11);
+    sti(R11, BANK_WINDOW);
+    movi(0, R10);
+    bank(R10);
+    ldi(BANK_WINDOW, R12);
+    movi(1, R10);
+    bank(R10);
+    ldi(BANK_WINDOW, R13);
+    halt();
+
+    vm->pc = 0;
+    vm_start(vm);
+
+    assert(vm->regfile[R12] == 0x1111);
+    assert(vm->regfile[R13] == 0xabcd);
+    assert(read_word(vm, BANK_WINDOW) == 0x1111);
+
+    printf("    allocates banks on first store\n");
+    reset_vm();
+
+    movi(7, R10);
+    bank(R10);
+    ldi(BANK_WINDOW + 10, R11);
+    halt();
+
+    vm->pc = 0;
+    vm_start(vm);
+
+    assert(vm->regfile[R11] == 0);
+    assert(vm->banks[7] == NULL);
+
+    printf("    leaves ram outside the window alone\n");
+    reset_vm();
+
+    movi(2, R10);
+    bank(R10);
+    movi(0xabcd, R11);
+    sti(R11, BANK_WINDOW - 2);
+    sti(R11, BANK_WINDOW + BANK_SIZE);
+    halt();
+
+    vm->pc = 0;
+    vm_start(vm);
+
+    assert(read_word(vm, BANK_WINDOW - 2) == 0xabcd);
+    assert(read_word(vm, BANK_WINDOW + BANK_SIZE) == 0xabcd);
+    assert(vm->banks[2] == NULL);
+
+    printf("    faults on an invalid bank\n");
+    reset_vm();
+
+    movi(BANK_COUNT, R10);
+    bank(R10);
+    movi(1, R11);
+    halt();
+
+    vm->pc = 0;
+    vm_start(vm);
+
+    assert(vm->bank == 0);
+    assert(vm->regfile[R11] == 0);
+}
@@ -0,0 +1,70 @@
+struct bcmp_test_case {
+    char *title;
+    char *a;
+    char *b;
+    int len;
+    int zf;
+    int cf;
+};
+
+struct bcmp_test_case bcmp_cases[] = {
+    {
+        .title = "equal blocks",
+        .a = "hello",
+        .b = "hello",
+        .len = 5,
+        .zf = 1,
+        .cf = 1
+    },
+    {
+        .title = "first block is above",
+        .a = "hellp",
+        .b = "hello",
+        .len = 5,
+        .zf = 0,
+        .cf = 1
+    },
+    {
+        .title = "first block is below",
+        .a = "hell\x01",
+        .b = "hell\xff",
+        .len = 5,
+        .zf = 0,
+        .cf = 0
+    },
+    {
+        .title = "difference past the length",
+        .a = "hellp",
+        .b = "hello",
+        .len = 4,
+        .zf = 1,
+        .cf = 1
+    }
+};
+
+void test_bcmp()
+{
+    printf("test_bcmp\n");
+
+    for (int i = 0; i < arrlen(bcmp_cases); ++i) {
+        struct bcmp_test_case tcase = bcmp_cases[i];
+
+        printf("    %s\n", tcase.title);
+        reset_vm();
+
+        memcpy(vm->ram + 0x1000, tcase.a, 5);
+        memcpy(vm->ram + 0x2000, tcase.b, 5);
+
+        vm->regfile[R10] = 0x2000;
+        vm->regfile[R11] = 0x1000;
+        vm->regfile[R12] = tcase.len;
+        bcmp(R10, R11, R12);
+        halt();
+
+        vm->pc = 0;
+        vm_start(vm);
+
+        assert(vm->flags[ZF] == tcase.zf);
+        assert(vm->flags[CF] == tcase.cf);
+    }
+}
@@ -0,0 +1,38 @@
+void test_bfill()
+{
+    printf("test_bfill\n");
+
+    printf("    fills a block\n");
+    reset_vm();
+
+    vm->regfile[R10] = 0xabcd;
+    vm->regfile[R11] = 0x1000;
+    vm->regfile[R12] = 300;
+    bfill(R10, R11, R12);
+    halt();
+
+    vm->pc = 0;
+    vm_start(vm);
+
+    for (int i = 0; i < 300; ++i) {
+        assert(read_byte(vm, 0x1000 + i) == 0xcd);
+    }
+    assert(read_byte(vm, 0x1000 + 300) == 0);
+
+    printf("    wraps around the end of ram\n");
+    reset_vm();
+
+    vm->pc = 0x100;
+    vm->regfile[R10] = 0xcd;
+    vm->regfile[R11] = 0xfffe;
+    vm->regfile[R12] = 4;
+    bfill(R10, R11, R12);
+    halt();
+
+    vm->pc = 0x100;
+    vm_start(vm);
+
+    assert(read_word(vm, 0xfffe) == 0xcdcd);
+    assert(read_word(vm, 0) == 0xcdcd);
+    assert(read_byte(vm, 2) == 0);
+}
@@ -0,0 +1,86 @@
+void test_bmov()
+{
+    printf("test_bmov\n");
+
+    printf("    copies a block\n");
+    reset_vm();
+
+    for (int i = 0; i < 300; ++i) {
+        write_byte(vm, i, 0x1000 + i);
+    }
+
+    vm->regfile[R10] = 0x1000;
+    vm->regfile[R11] = 0x2000;
+    vm->regfile[R12] = 300;
+    bmov(R10, R11, R12);
+    halt();
+
+    vm->pc = 0;
+    vm_start(vm);
+
+    assert(memcmp(vm->ram + 0x1000, vm->ram + 0x2000, 300) == 0);
+    assert(read_byte(vm, 0x2000 + 300) == 0);
+
+    printf("    handles overlapping blocks\n");
+    reset_vm();
+
+    for (int i = 0; i < 16; ++i) {
+        write_byte(vm, i, 0x1000 + i);
+    }
+
+    vm->regfile[R10] = 0x1000;
+    vm->regfile[R11] = 0x1004;
+    vm->regfile[R12] = 16;
+    bmov(R10, R11, R12);
+    halt();
+
+    vm->pc = 0;
+    vm_start(vm);
+
+    for (int i = 0; i < 16; ++i) {
+        assert(read_byte(vm, 0x1004 + i) == i);
+    }
+
+    printf("    wraps around the end of ram\n");
+    reset_vm();
+
+    for (int i = 0; i < 16; ++i) {
+        write_byte(vm, 0xa0 + i, 0xfff8 + i);
+    }
+
+    vm->pc = 0x100;
+    vm->regfile[R10] = 0xfff8;
+    vm->regfile[R11] = 0x1000;
+    vm->regfile[R12] = 16;
+    bmov(R10, R11, R12);
+    halt();
+
+    vm->pc = 0x100;
+    vm_start(vm);
+
+    for (int i = 0; i < 16; ++i) {
+        assert(read_byte(vm, 0x1000 + i) == (uint8_t) (0xa0 + i));
+    }
+
+    printf("    copies through devices\n");
+    reset_vm();
+
+    for (int i = 0; i < 8; ++i) {
+        write_byte(vm, 'a' + i, 0x1000 + i);
+    }
+
+    vm->regfile[R10] = 0x1000;
+    vm->regfile[R11] = 0x8000 - 4;
+    vm->regfile[R12] = 8;
+    movi(1, R13);
+    bank(R13);
+    bmov(R10, R11, R12);
+    halt();
+
+    vm->pc = 0;
+    vm_start(vm);
+
+    assert(memcmp(vm->ram + 0x8000 - 4, "abcd", 4) == 0);
+    assert(read_byte(vm, 0x8000) == 0);
+    assert(memcmp(vm->banks[1], "efgh", 4) == 0);
+}
@@ -0,0 +1,56 @@
+void test_br()
+{
+    printf("test_br\n");
+
+    printf("    branches forward\n");
+    reset_vm();
+
+    br(0x1000);
+    movi(0, R10);
+    halt();
+
+    vm->pc = 0x1000;
+    movi(1, R10);
+    halt();
+
+    vm->pc = 0;
+    vm_start(vm);
+
+    assert(vm->regfile[R10] == 1);
+
+    printf("    branches backward\n");
+    reset_vm();
+
+    vm->pc = 0x10;
+    movi(1, R10);
+    halt();
+
+    vm->pc = 0x1000;
+    br(0x10);
+    halt();
+
+    vm->pc = 0x1000;
+    vm_start(vm);
+
+    assert(vm->regfile[R10] == 1);
+
+    printf("    same code runs at another address\n");
+    reset_vm();
+
+    vm->pc = 0x100;
+    br(0x108);
+    movi(0, R10);
+    halt();
+    vm->pc = 0x108;
+    movi(1, R10);
+    halt();
+
+    memcpy(vm->ram + 0x3000, vm->ram + 0x100, 16);
+    memset(vm->ram + 0x100, 0, 16);
+
+    vm->pc = 0x3000;
+    vm_start(vm);
+
+    assert(vm->regfile[R10] == 1);
+    assert(vm->pc == 0x3000 + 13);
+}
@@ -0,0 +1,57 @@
+struct brcc_test_case {
+    char *title;
+    enum vm_opcode op;
+    uint16_t a;
+    uint16_t b;
+    uint16_t expect;
+};
+
+struct brcc_test_case brcc_cases[] = {
+    { .title = "bre branches", .op = BRE, .a = 5, .b = 5, .expect = 1 },
+    { .title = "bre falls through", .op = BRE, .a = 5, .b = 4, .expect = 0 },
+    { .title = "brne branches", .op = BRNE, .a = 5, .b = 4, .expect = 1 },
+    { .title = "brne falls through", .op = BRNE, .a = 5, .b = 5, .expect = 0 },
+    { .title = "brg branches", .op = BRG, .a = 5, .b = 0xfffb, .expect = 1 },
+    { .title = "brg falls through", .op = BRG, .a = 5, .b = 5, .expect = 0 },
+    { .title = "brge branches", .op = BRGE, .a = 5, .b = 5, .expect = 1 },
+    { .title = "brge falls through", .op = BRGE, .a = 0xfffb, .b = 5, .expect = 0 },
+    { .title = "brl branches", .op = BRL, .a = 0xfffb, .b = 5, .expect = 1 },
+    { .title = "brl falls through", .op = BRL, .a = 5, .b = 5, .expect = 0 },
+    { .title = "brle branches", .op = BRLE, .a = 5, .b = 5, .expect = 1 },
+    { .title = "brle falls through", .op = BRLE, .a = 5, .b = 0xfffb, .expect = 0 },
+    { .title = "bra branches", .op = BRA, .a = 0xfffb, .b = 5, .expect = 1 },
+    { .title = "bra falls through", .op = BRA, .a = 5, .b = 5, .expect = 0 },
+    { .title = "brae branches", .op = BRAE, .a = 5, .b = 5, .expect = 1 },
+    { .title = "brae falls through", .op = BRAE, .a = 4, .b = 5, .expect = 0 },
+    { .title = "brb branches", .op = BRB, .a = 4, .b = 5, .expect = 1 },
+    { .title = "brb falls through", .op = BRB, .a = 5, .b = 5, .expect = 0 },
+    { .title = "brbe branches", .op = BRBE, .a = 5, .b = 5, .expect = 1 },
+    { .title = "brbe falls through", .op = BRBE, .a = 0xfffb, .b = 5, .expect = 0 }
+};
+
+void test_brcc()
+{
+    printf("test_brcc\n");
+
+    for (int i = 0; i < arrlen(brcc_cases); ++i) {
+        struct brcc_test_case tcase = brcc_cases[i];
+
+        printf("    %s\n", tcase.title);
+        reset_vm();
+
+        vm->regfile[R10] = tcase.a;
+        cmpi(tcase.b, R10);
+        brcc(tcase.op, 69);
+        movi(0, R10);
+        halt();
+
+        vm->pc = 69;
+        movi(1, R10);
+        halt();
+
+        vm->pc = 0;
+        vm_start(vm);
+
+        assert(vm->regfile[R10] == tcase.expect);
+    }
+}
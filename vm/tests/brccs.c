@@ -0,0 +1,27 @@
+
+void test_brccs()
+{
+    printf("test_brccs\n");
+
+    for (int i = 0; i < arrlen(brcc_cases); ++i) {
+        struct brcc_test_case tcase = brcc_cases[i];
+
+        printf("    %s\n", tcase.title);
+        reset_vm();
+
+        vm->regfile[R10] = tcase.a;
+        cmpi(tcase.b, R10);
+        brccs(tcase.op - BRE + BRES, 69);
+        movi(0, R10);
+        halt();
+
+        vm->pc = 69;
+        movi(1, R10);
+        halt();
+
+        vm->pc = 0;
+        vm_start(vm);
+
+        assert(vm->regfile[R10] == tcase.expect);
+    }
+}
@@ -0,0 +1,36 @@
+void test_brs()
+{
+    printf("test_brs\n");
+
+    printf("    branches forward\n");
+    reset_vm();
+
+    brs(100);
+    movi(0, R10);
+    halt();
+
+    vm->pc = 100;
+    movi(1, R10);
+    halt();
+
+    vm->pc = 0;
+    vm_start(vm);
+
+    assert(vm->regfile[R10] == 1);
+
+    printf("    branches backward\n");
+    reset_vm();
+
+    vm->pc = 0x1000 - 128 + 2;
+    movi(1, R10);
+    halt();
+
+    vm->pc = 0x1000;
+    brs(0x1000 - 128 + 2);
+    halt();
+
+    vm->pc = 0x1000;
+    vm_start(vm);
+
+    assert(vm->regfile[R10] == 1);
+}
@@ -0,0 +1,20 @@
+void test_bsr()
+{
+    printf("test_bsr\n");
+    reset_vm();
+
+    vm->pc = 0x1000;
+    bsr(0x10);
+    movi(2, R11);
+    halt();
+
+    vm->pc = 0x10;
+    movi(1, R10);
+    ret();
+
+    vm->pc = 0x1000;
+    vm_start(vm);
+
+    assert(vm->regfile[R10] == 1);
+    assert(vm->regfile[R11] == 2);
+}
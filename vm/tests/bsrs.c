@@ -0,0 +1,19 @@
+void test_bsrs()
+{
+    printf("test_bsrs\n");
+    reset_vm();
+
+    bsrs(69);
+    movi(2, R11);
+    halt();
+
+    vm->pc = 69;
+    movi(1, R10);
+    ret();
+
+    vm->pc = 0;
+    vm_start(vm);
+
+    assert(vm->regfile[R10] == 1);
+    assert(vm->regfile[R11] == 2);
+}
@@ -0,0 +1,113 @@
+struct test_device {
+    struct device dev;
+    uint8_t mem[1 << PAGE_BITS];
+    int reads;
+    int writes;
+    int last_len;
+};
+
+void test_device_read(struct vm *vm, struct device *dev, uint16_t addr, uint8_t *buf, int len)
+{
+    struct test_device *td = (struct test_device *) dev;
+
+    td->reads++;
+    td->last_len = len;
+    memcpy(buf, td->mem + (addr & 0xff), len);
+}
+
+void test_device_write(struct vm *vm, struct device *dev, uint16_t addr, uint8_t *buf, int len)
+{
+    struct test_device *td = (struct test_device *) dev;
+
+    td->writes++;
+    td->last_len = len;
+    memcpy(td->mem + (addr & 0xff), buf, len);
+}
+
+void test_bus()
+{
+    struct test_device td = {
+        .dev = {
+            .read = test_device_read,
+            .write = test_device_write
+        }
+    };
+
+    printf("test_bus\n");
+
+    printf("    routes loads and stores to the device\n");
+    reset_vm();
+    assert(bus_map(vm, &td.dev, 0x8000, 1 << PAGE_BITS) == 0);
+
+    vm->regfile[R10] = 0xabcd;
+    vm->regfile[R11] = 0x8010;
+
+    st(R10, R11);
+    ld(R11, R12);
+    stb(R10, R11);
+    ldb(R11, R13);
+    halt();
+
+    vm->pc = 0;
+    vm_start(vm);
+
+    assert(td.mem[0x10] == 0xcd);
+    assert(td.mem[0x11] == 0xab);
+    assert(vm->regfile[R12] == 0xabcd);
+    assert((vm->regfile[R13] & 0xff) == 0xcd);
+    assert(td.reads == 2 && td.writes == 2);
+    assert(read_word(vm, 0x8010) == 0);
+
+    printf("    hands a word over in one access\n");
+    reset_vm();
+    memset(&td.mem, 0, sizeof(td.mem));
+    td.reads = td.writes = 0;
+    assert(bus_map(vm, &td.dev, 0x8000, 1 << PAGE_BITS) == 0);
+
+    vm->regfile[R10] = 0x1234;
+
+    sti(R10, 0x8020);
+    halt();
+
+    vm->pc = 0;
+    vm_start(vm);
+
+    assert(td.writes == 1 && td.last_len == 2);
+
+    printf("    splits a word that spans ram and a device\n");
+    reset_vm();
+    memset(&td.mem, 0, sizeof(td.mem));
+    assert(bus_map(vm, &td.dev, 0x8000, 1 << PAGE_BITS) == 0);
+
+    vm->regfile[R10] = 0xabcd;
+
+    sti(R10, 0x7fff);
+    ldi(0x7fff, R11);
+    halt();
+
+    vm->pc = 0;
+    vm_start(vm);
+
+    assert(read_byte(vm, 0x7fff) == 0xcd);
+    assert(td.mem[0] == 0xab);
+    assert(vm->regfile[R11] == 0xabcd);
+
+    printf("    leaves ram pages alone\n");
+    reset_vm();
+    assert(bus_map(vm, &td.dev, 0x8000, 1 << PAGE_BITS) == 0);
+
+    vm->regfile[R10] = 0xabcd;
+
+    sti(R10, 0x9000);
+    halt();
+
+    vm->pc = 0;
+    vm_start(vm);
+
+    assert(read_word(vm, 0x9000) == 0xabcd);
+
+    printf("    rejects unaligned mappings\n");
+    reset_vm();
+
+    assert(bus_map(vm, &td.dev, 0x8001, 1 << PAGE_BITS) == -1);
+}
@@ -5,12 +5,12 @@ void test_call()
 
     call(69);
 
-    pc = 69;
+    vm->pc = 69;
     movi(1, R10);
     halt();
 
-    pc = 0;
-    vm_start();
+    vm->pc = 0;
+    vm_start(vm);
 
-    assert(regfile[R10] == 1);
+    assert(vm->regfile[R10] == 1);
 }
@@ -3,15 +3,15 @@ void test_callr()
     printf("test_callr\n");
     reset_vm();
 
-    regfile[R10] = 69;
+    vm->regfile[R10] = 69;
     callr(R10);
 
-    pc = 69;
+    vm->pc = 69;
     movi(1, R10);
     halt();
 
-    pc = 0;
-    vm_start();
+    vm->pc = 0;
+    vm_start(vm);
 
-    assert(regfile[R10] == 1);
+    assert(vm->regfile[R10] == 1);
 }
@@ -0,0 +1,202 @@
+enum {
+    CHANNEL_THREADS = 4,
+    CHANNEL_MESSAGES = 20000
+};
+
+// Sends CHANNEL_MESSAGES numbered messages, retrying while the queue is full.
+void *channel_sender(void *arg)
+{
+    struct vm_channel *ch = arg;
+    static int next_id;
+    uint32_t msg[2];
+
+    msg[0] = __atomic_fetch_add(&next_id, 1, __ATOMIC_RELAXED);
+    for (uint32_t i = 0; i < CHANNEL_MESSAGES; ++i) {
+        msg[1] = i;
+        while (vm_channel_send(ch, msg, sizeof(msg)) != 0) {
+            sched_yield();
+        }
+    }
+
+    return NULL;
+}
+
+// Sends the CHANNEL_LEN bytes at 0x200 on endpoint R10, the status goes to
+// R13.
+void write_channel_send(uint16_t len)
+{
+    movi(0x200, R11);
+    sti(R11, CHANNEL_ADDR);
+    movi(len, R11);
+    sti(R11, CHANNEL_LEN);
+    stbi(R10, CHANNEL_SEND);
+    ldbi(CHANNEL_STATUS, R13);
+}
+
+// Receives into 0x300 from endpoint R10, the status goes to R13 and the
+// length to R12.
+void write_channel_receive(uint16_t len)
+{
+    movi(0x300, R11);
+    sti(R11, CHANNEL_ADDR);
+    movi(len, R11);
+    sti(R11, CHANNEL_LEN);
+    stbi(R10, CHANNEL_RECEIVE);
+    ldbi(CHANNEL_STATUS, R13);
+    ldi(CHANNEL_LEN, R12);
+}
+
+void test_channel()
+{
+    struct channel_port port;
+    struct vm_channel *ch;
+    uint8_t buf[16];
+    pthread_t threads[CHANNEL_THREADS];
+    uint32_t seen[CHANNEL_THREADS];
+
+    printf("test_channel\n");
+
+    printf("    sends from ram\n");
+    reset_vm();
+    assert(channel_port_attach(vm, &port) == 0);
+    ch = vm_channel_create(2, 8);
+    assert(ch != NULL);
+    port.channels[1] = ch;
+
+    memcpy(vm->ram + 0x200, "hello", 5);
+    movi(1, R10);
+    write_channel_send(5);
+    halt();
+
+    vm->pc = 0;
+    vm_start(vm);
+
+    assert(vm->regfile[R13] == 1);
+    assert(vm_channel_receive(ch, buf, sizeof(buf)) == 5);
+    assert(memcmp(buf, "hello", 5) == 0);
+
+    printf("    receives into ram\n");
+    reset_vm();
+    assert(channel_port_attach(vm, &port) == 0);
+    port.channels[1] = ch;
+    ch->receiver = vm;
+
+    assert(vm_channel_send(ch, "abcdef", 6) == 0);
+    movi(1, R10);
+    write_channel_receive(16);
+    halt();
+
+    vm->pc = 0;
+    vm_start(vm);
+
+    assert(vm->regfile[R13] == 1);
+    assert(vm->regfile[R12] == 6);
+    assert(memcmp(vm->ram + 0x300, "abcdef", 6) == 0);
+
+    printf("    truncates to the length\n");
+    reset_vm();
+    assert(channel_port_attach(vm, &port) == 0);
+    port.channels[1] = ch;
+
+    assert(vm_channel_send(ch, "abcdef", 6) == 0);
+    movi(1, R10);
+    write_channel_receive(2);
+    halt();
+
+    vm->pc = 0;
+    vm_start(vm);
+
+    assert(vm->regfile[R12] == 2);
+    assert(memcmp(vm->ram + 0x300, "ab\0", 3) == 0);
+    assert(vm_channel_receive(ch, buf, sizeof(buf)) == -1);
+
+    printf("    fails when full, empty or unattached\n");
+    reset_vm();
+    assert(channel_port_attach(vm, &port) == 0);
+    port.channels[1] = ch;
+
+    assert(vm_channel_send(ch, "a", 1) == 0);
+    assert(vm_channel_send(ch, "b", 1) == 0);
+    assert(vm_channel_send(ch, "c", 1) == -1);
+
+    movi(1, R10);
+    write_channel_send(1);
+    mov(R13, R8);
+    write_channel_send(9);
+    mov(R13, R9);
+    movi(2, R10);
+    write_channel_send(1);
+    halt();
+
+    vm->pc = 0;
+    vm_start(vm);
+
+    assert(vm->regfile[R8] == 0);
+    assert(vm->regfile[R9] == 0);
+    assert(vm->regfile[R13] == 0);
+
+    assert(vm_channel_receive(ch, buf, 1) == 1 && buf[0] == 'a');
+    assert(vm_channel_receive(ch, buf, 1) == 1 && buf[0] == 'b');
+
+    reset_vm();
+    assert(channel_port_attach(vm, &port) == 0);
+    port.channels[1] = ch;
+
+    movi(1, R10);
+    write_channel_receive(16);
+    halt();
+
+    vm->pc = 0;
+    vm_start(vm);
+
+    assert(vm->regfile[R13] == 0);
+
+    printf("    only the receiver receives\n");
+    reset_vm();
+    assert(channel_port_attach(vm, &port) == 0);
+    port.channels[1] = ch;
+    ch->receiver = NULL;
+
+    assert(vm_channel_send(ch, "a", 1) == 0);
+    movi(1, R10);
+    write_channel_receive(16);
+    halt();
+
+    vm->pc = 0;
+    vm_start(vm);
+
+    assert(vm->regfile[R13] == 0);
+    assert(vm_channel_receive(ch, buf, 1) == 1 && buf[0] == 'a');
+
+    vm_channel_destroy(ch);
+
+    printf("    keeps each sender's order across threads\n");
+    ch = vm_channel_create(64, 8);
+    assert(ch != NULL);
+
+    for (int i = 0; i < CHANNEL_THREADS; ++i) {
+        assert(pthread_create(&threads[i], NULL, channel_sender, ch) == 0);
+        seen[i] = 0;
+    }
+
+    for (int n = 0; n < CHANNEL_THREADS * CHANNEL_MESSAGES; ) {
+        uint32_t msg[2];
+
+        if (vm_channel_receive(ch, msg, sizeof(msg)) != sizeof(msg)) {
+            sched_yield();
+            continue;
+        }
+
+        assert(msg[0] < CHANNEL_THREADS);
+        assert(msg[1] == seen[msg[0]]);
+        seen[msg[0]]++;
+        n++;
+    }
+
+    for (int i = 0; i < CHANNEL_THREADS; ++i) {
+        pthread_join(threads[i], NULL);
+        assert(seen[i] == CHANNEL_MESSAGES);
+    }
+
+    vm_channel_destroy(ch);
+}
@@ -0,0 +1,78 @@
+struct cmov_test_case {
+    char *title;
+    enum vm_condition cond;
+    uint16_t a;
+    uint16_t b;
+    uint16_t expect;
+};
+
+struct cmov_test_case cmov_cases[] = {
+    {
+        .title = "moves when equal",
+        .cond = COND_E,
+        .a = 5,
+        .b = 5,
+        .expect = 0xabcd
+    },
+    {
+        .title = "keeps destination when not equal",
+        .cond = COND_E,
+        .a = 5,
+        .b = 4,
+        .expect = 0x1234
+    },
+    {
+        .title = "signed less",
+        .cond = COND_L,
+        .a = 0xfffb,
+        .b = 5,
+        .expect = 0xabcd
+    },
+    {
+        .title = "unsigned below",
+        .cond = COND_B,
+        .a = 0xfffb,
+        .b = 5,
+        .expect = 0x1234
+    }
+};
+
+void test_cmov()
+{
+    printf("test_cmov\n");
+
+    for (int i = 0; i < arrlen(cmov_cases); ++i) {
+        struct cmov_test_case tcase = cmov_cases[i];
+
+        printf("    %s\n", tcase.title);
+        reset_vm();
+
+        vm->regfile[R10] = tcase.a;
+        vm->regfile[R11] = 0xabcd;
+        vm->regfile[R12] = 0x1234;
+        cmpi(tcase.b, R10);
+        cmov(tcase.cond, R11, R12);
+        halt();
+
+        vm->pc = 0;
+        vm_start(vm);
+
+        assert(vm->regfile[R12] == tcase.expect);
+    }
+
+    printf("    min of two registers without a branch\n");
+    reset_vm();
+
+    vm->regfile[R10] = 7;
+    vm->regfile[R11] = 3;
+    cmp(R11, R10);
+    cmov(COND_G, R11, R10);
+    halt();
+
+    assert(verify_image(vm, 0) == 0);
+
+    vm->pc = 0;
+    vm_start(vm);
+
+    assert(vm->regfile[R10] == 3);
+}
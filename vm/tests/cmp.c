@@ -42,6 +42,13 @@ struct cmp_test_case cmp_cases[] = {
         .flag = CF,
         .expect = 1
     },
+    {
+        .title = "carry flag is set when subtracting zero",
+        .a = 5,
+        .b = 0,
+        .flag = CF,
+        .expect = 1
+    },
     {
         .title = "carry flag is not set",
         .a = 1,
@@ -89,14 +96,14 @@ void test_cmp()
         printf("    %s\n", tcase.title);
         reset_vm();
 
-        regfile[R10] = tcase.a;
-        regfile[R11] = tcase.b;
+        vm->regfile[R10] = tcase.a;
+        vm->regfile[R11] = tcase.b;
         cmp(R11, R10);
         halt();
 
-        pc = 0;
-        vm_start();
+        vm->pc = 0;
+        vm_start(vm);
 
-        assert(flags[tcase.flag] == tcase.expect);
+        assert(vm->flags[tcase.flag] == tcase.expect);
     }
 }
@@ -88,14 +88,14 @@ void test_cmpb()
         printf("    %s\n", tcase.title);
         reset_vm();
 
-        regfile[R10] = tcase.a;
-        regfile[R11] = tcase.b;
+        vm->regfile[R10] = tcase.a;
+        vm->regfile[R11] = tcase.b;
         cmpb(R11, R10);
         halt();
 
-        pc = 0;
-        vm_start();
+        vm->pc = 0;
+        vm_start(vm);
 
-        assert(flags[tcase.flag] == tcase.expect);
+        assert(vm->flags[tcase.flag] == tcase.expect);
     }
 }
@@ -8,14 +8,14 @@ void test_cmpi()
         printf("    %s\n", tcase.title);
         reset_vm();
 
-        regfile[R10] = tcase.a;
+        vm->regfile[R10] = tcase.a;
         cmpi(tcase.b, R10);
         halt();
 
-        pc = 0;
-        vm_start();
+        vm->pc = 0;
+        vm_start(vm);
 
-        assert(flags[tcase.flag] == tcase.expect);
+        assert(vm->flags[tcase.flag] == tcase.expect);
     }
 }
 
@@ -0,0 +1,76 @@
+void test_console()
+{
+    struct console con;
+    int fds[2];
+    char out[512];
+
+    printf("test_console\n");
+    assert(pipe(fds) == 0);
+
+    printf("    flushes on halt\n");
+    reset_vm();
+    assert(console_attach(vm, &con, fds[1]) == 0);
+
+    movbi('h', R10);
+    stbi(R10, CONSOLE_RING);
+    movbi('i', R10);
+    stbi(R10, CONSOLE_RING + 1);
+    movi(2, R11);
+    sti(R11, CONSOLE_TAIL);
+    halt();
+
+    vm->pc = 0;
+    vm_start(vm);
+
+    assert(con.flushes == 1);
+    assert(read(fds[0], out, sizeof(out)) == 2);
+    assert(memcmp(out, "hi", 2) == 0);
+
+    printf("    flushes on request\n");
+    reset_vm();
+    assert(console_attach(vm, &con, fds[1]) == 0);
+
+    movbi('x', R10);
+    stbi(R10, CONSOLE_RING);
+    movi(1, R11);
+    sti(R11, CONSOLE_TAIL);
+    stbi(R10, CONSOLE_FLUSH);
+    ldi(CONSOLE_HEAD, R12);
+    halt();
+
+    vm->pc = 0;
+    vm_start(vm);
+
+    assert(vm->regfile[R12] == 1);
+    assert(con.flushes == 1);
+    assert(read(fds[0], out, sizeof(out)) == 1);
+    assert(out[0] == 'x');
+
+    printf("    flushes a full ring with one write\n");
+    reset_vm();
+    assert(console_attach(vm, &con, fds[1]) == 0);
+
+    for (int i = 0; i < CONSOLE_RING_SIZE; ++i) {
+        write_byte(vm, 'a' + i % 26, CONSOLE_RING + i);
+    }
+
+    // Start half way round so the pending bytes wrap.
+    con.head = con.tail = 128;
+
+    movi(128 + CONSOLE_RING_SIZE, R11);
+    sti(R11, CONSOLE_TAIL);
+    ldi(CONSOLE_HEAD, R12);
+    halt();
+
+    vm->pc = 0;
+    vm_start(vm);
+
+    assert(vm->regfile[R12] == 128 + CONSOLE_RING_SIZE);
+    assert(con.flushes == 1);
+    assert(read(fds[0], out, sizeof(out)) == CONSOLE_RING_SIZE);
+    assert(out[0] == 'a' + 128 % 26);
+    assert(out[CONSOLE_RING_SIZE - 1] == 'a' + 127 % 26);
+
+    close(fds[0]);
+    close(fds[1]);
+}
@@ -0,0 +1,91 @@
+struct crc32c_test_case {
+    char *title;
+    char *data;
+    uint32_t crc;
+    uint32_t expect;
+};
+
+struct crc32c_test_case crc32c_cases[] = {
+    {
+        .title = "empty buffer",
+        .data = "",
+        .crc = 0,
+        .expect = 0
+    },
+    {
+        .title = "check value",
+        .data = "123456789",
+        .crc = 0,
+        .expect = 0xe3069283
+    },
+    {
+        .title = "several 8 byte strides and a tail",
+        .data = "The quick brown fox jumps over the lazy dog",
+        .crc = 0,
+        .expect = 0x22620404
+    },
+    {
+        .title = "continues a previous checksum",
+        .data = "56789",
+        .crc = 0,
+        .expect = 0xe3069283
+    }
+};
+
+void test_crc32c()
+{
+    char *fox;
+
+    printf("test_crc32c\n");
+
+    // The continued case starts from the checksum of "1234".
+    crc32c_cases[3].crc = crc32c_update(0, (uint8_t *) "1234", 4);
+
+    for (int i = 0; i < arrlen(crc32c_cases); ++i) {
+        struct crc32c_test_case tcase = crc32c_cases[i];
+        int len = strlen(tcase.data);
+
+        printf("    %s\n", tcase.title);
+        reset_vm();
+
+        memcpy(vm->ram + 0x1000, tcase.data, len);
+
+        vm->regfile[R10] = 0x1000;
+        vm->regfile[R11] = len;
+        vm->regfile[R12] = tcase.crc;
+        vm->regfile[R13] = tcase.crc >> 16;
+        crc32c(R10, R11, R12, R13);
+        halt();
+
+        vm->pc = 0;
+        vm_start(vm);
+
+        assert(vm->regfile[R12] == (uint16_t) tcase.expect);
+        assert(vm->regfile[R13] == tcase.expect >> 16);
+        assert(vm->regfile[R10] == 0x1000);
+        assert(vm->regfile[R11] == len);
+    }
+
+    printf("    wraps around the end of ram\n");
+    reset_vm();
+
+    for (int i = 0; i < 9; ++i) {
+        write_byte(vm, '1' + i, 0xfffc + i);
+    }
+
+    vm->pc = 0x100;
+    vm->regfile[R10] = 0xfffc;
+    vm->regfile[R11] = 9;
+    crc32c(R10, R11, R12, R13);
+    halt();
+
+    vm->pc = 0x100;
+    vm_start(vm);
+
+    assert(vm->regfile[R12] == 0x9283);
+    assert(vm->regfile[R13] == 0xe306);
+
+    printf("    table fallback gives the same checksum\n");
+    fox = "The quick brown fox jumps over the lazy dog";
+    assert(~crc32c_slice8(~0u, (uint8_t *) fox, strlen(fox)) == 0x22620404);
+}
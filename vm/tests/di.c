@@ -0,0 +1,14 @@
+void test_di()
+{
+    printf("test_di\n");
+    reset_vm();
+
+    ei();
+    di();
+    halt();
+
+    vm->pc = 0;
+    vm_start(vm);
+
+    assert(vm->flags[IF] == 0);
+}
@@ -0,0 +1,150 @@
+struct disassemble_test_case {
+    char *title;
+    enum vm_opcode op;
+    uint16_t operands[4];
+    char *expect;
+};
+
+struct disassemble_test_case disassemble_cases[] = {
+    {
+        .title = "no operands",
+        .op = HALT,
+        .expect = "HALT"
+    },
+    {
+        .title = "register pair",
+        .op = MOV,
+        .operands = {R1, RSP},
+        .expect = "MOV R1, RSP"
+    },
+    {
+        .title = "immediate and register",
+        .op = MOVI,
+        .operands = {0x1234, R10},
+        .expect = "MOVI 0x1234, R10"
+    },
+    {
+        .title = "byte immediate",
+        .op = ADDBI,
+        .operands = {0x7f, R2},
+        .expect = "ADDBI 0x7f, R2"
+    },
+    {
+        .title = "condition",
+        .op = CMOV,
+        .operands = {COND_LE, R3, R4},
+        .expect = "CMOV LE, R3, R4"
+    },
+    {
+        .title = "four registers",
+        .op = CRC32C,
+        .operands = {R1, R2, R8, RBP},
+        .expect = "CRC32C R1, R2, R8, RBP"
+    },
+    {
+        .title = "scaled index",
+        .op = LDX,
+        .operands = {R1, R2, 8, RBP},
+        .expect = "LDX R1, R2, 8, RBP"
+    },
+    {
+        .title = "invalid register",
+        .op = PUSH,
+        .operands = {0x20},
+        .expect = "PUSH ?0x20"
+    }
+};
+
+void test_disassemble()
+{
+    char buf[64];
+
+    printf("test_disassemble\n");
+
+    for (int i = 0; i < arrlen(disassemble_cases); ++i) {
+        struct disassemble_test_case tcase = disassemble_cases[i];
+        int size;
+
+        printf("    %s\n", tcase.title);
+        reset_vm();
+
+        size = encode_instruction(vm, 0x100, tcase.op, tcase.operands);
+
+        assert(disassemble(vm, 0x100, buf, sizeof(buf)) == size);
+        assert(strcmp(buf, tcase.expect) == 0);
+    }
+
+    printf("    unknown opcode\n");
+    reset_vm();
+
+    write_byte(vm, VM_OPCODE_COUNT, 0x100);
+
+    assert(disassemble(vm, 0x100, buf, sizeof(buf)) == 1);
+    assert(strncmp(buf, ".byte 0x", 8) == 0);
+
+    printf("    fixed encoding reads the same\n");
+    reset_vm();
+
+    vm->encoding = ENCODING_FIXED;
+    movi(0x1234, R10);
+    bmov(R1, R2, R3);
+
+    assert(disassemble(vm, 0, buf, sizeof(buf)) == 4);
+    assert(strcmp(buf, "MOVI 0x1234, R10") == 0);
+    assert(disassemble(vm, 4, buf, sizeof(buf)) == 4);
+    assert(strcmp(buf, "BMOV R1, R2, R3") == 0);
+
+    printf("    every opcode round trips in both encodings\n");
+
+    for (int op = 0; op < VM_OPCODE_COUNT; ++op) {
+        enum operand_layout layout = opcode_layout[op];
+        enum operand_kind *kinds = operand_kinds[layout];
+        uint16_t in[4], out[4];
+        int offset, reg8_at, imm_at;
+
+        offset = 1;
+        reg8_at = 0;
+        imm_at = 0;
+        for (int i = 0; i < operand_count(op); ++i) {
+            switch (kinds[i]) {
+            case OPERAND_REG4:
+            case OPERAND_SCALE:
+                in[i] = (op + i) & 0x0f;
+                if (i % 2 == 1) {
+                    ++offset;
+                }
+                break;
+            case OPERAND_REG8:
+                in[i] = (op + i) & 0x0f;
+                reg8_at = offset;
+                ++offset;
+                break;
+            case OPERAND_IMM16:
+                in[i] = 0x1234 + op;
+                imm_at = offset;
+                offset += 2;
+                break;
+            default:
+                in[i] = kinds[i] == OPERAND_COND ? COND_BE : 0x7f;
+                imm_at = offset;
+                ++offset;
+                break;
+            }
+        }
+
+        assert(offset == 1 + operand_size[layout]);
+        assert(reg8_at == reg8_offset[layout]);
+        assert(imm_at == imm_offset[layout]);
+
+        for (int e = ENCODING_VARIABLE; e <= ENCODING_FIXED; ++e) {
+            reset_vm();
+            vm->encoding = e;
+
+            assert(encode_instruction(vm, 0x100, op, in) == instruction_size(vm, op));
+            assert(decode_operands(vm, 0x100, out) == instruction_size(vm, op));
+            assert(memcmp(in, out, operand_count(op) * sizeof(*in)) == 0);
+            assert(disassemble(vm, 0x100, buf, sizeof(buf)) == instruction_size(vm, op));
+            assert(strncmp(buf, opcode_name[op], strlen(opcode_name[op])) == 0);
+        }
+    }
+}
@@ -0,0 +1,64 @@
+struct div_test_case {
+    char *title;
+    uint16_t a;
+    uint16_t b;
+    uint16_t expect;
+};
+
+struct div_test_case div_cases[] = {
+    {
+        .title = "divide",
+        .a = 7,
+        .b = 2,
+        .expect = 3
+    },
+    {
+        .title = "unsigned operands",
+        .a = 0xffff,
+        .b = 2,
+        .expect = 0x7fff
+    },
+    {
+        .title = "divide zero",
+        .a = 0,
+        .b = 5,
+        .expect = 0
+    }
+};
+
+void test_div()
+{
+    printf("test_div\n");
+
+    for (int i = 0; i < arrlen(div_cases); ++i) {
+        struct div_test_case tcase = div_cases[i];
+
+        printf("    %s\n", tcase.title);
+        reset_vm();
+
+        vm->regfile[R10] = tcase.a;
+        vm->regfile[R11] = tcase.b;
+        div(R11, R10);
+        halt();
+
+        vm->pc = 0;
+        vm_start(vm);
+
+        assert(vm->regfile[R10] == tcase.expect);
+    }
+
+    printf("    division by zero faults\n");
+    reset_vm();
+
+    vm->regfile[R10] = 7;
+    vm->regfile[R11] = 0;
+    div(R11, R10);
+    movi(1, R12);
+    halt();
+
+    vm->pc = 0;
+    vm_start(vm);
+
+    assert(vm->regfile[R10] == 7);
+    assert(vm->regfile[R12] == 0);
+}
@@ -0,0 +1,35 @@
+
+void test_divi()
+{
+    printf("test_divi\n");
+
+    for (int i = 0; i < arrlen(div_cases); ++i) {
+        struct div_test_case tcase = div_cases[i];
+
+        printf("    %s\n", tcase.title);
+        reset_vm();
+
+        vm->regfile[R10] = tcase.a;
+        divi(tcase.b, R10);
+        halt();
+
+        vm->pc = 0;
+        vm_start(vm);
+
+        assert(vm->regfile[R10] == tcase.expect);
+    }
+
+    printf("    division by zero faults\n");
+    reset_vm();
+
+    vm->regfile[R10] = 7;
+    divi(0, R10);
+    movi(1, R12);
+    halt();
+
+    vm->pc = 0;
+    vm_start(vm);
+
+    assert(vm->regfile[R10] == 7);
+    assert(vm->regfile[R12] == 0);
+}
@@ -0,0 +1,49 @@
+struct divs_test_case {
+    char *title;
+    uint16_t a;
+    uint16_t b;
+    uint16_t expect;
+};
+
+struct divs_test_case divs_cases[] = {
+    {
+        .title = "negative dividend",
+        .a = 0xfff9,
+        .b = 2,
+        .expect = 0xfffd
+    },
+    {
+        .title = "negative divisor",
+        .a = 7,
+        .b = 0xfffe,
+        .expect = 0xfffd
+    },
+    {
+        .title = "overflow wraps",
+        .a = 0x8000,
+        .b = 0xffff,
+        .expect = 0x8000
+    }
+};
+
+void test_divs()
+{
+    printf("test_divs\n");
+
+    for (int i = 0; i < arrlen(divs_cases); ++i) {
+        struct divs_test_case tcase = divs_cases[i];
+
+        printf("    %s\n", tcase.title);
+        reset_vm();
+
+        vm->regfile[R10] = tcase.a;
+        vm->regfile[R11] = tcase.b;
+        divs(R11, R10);
+        halt();
+
+        vm->pc = 0;
+        vm_start(vm);
+
+        assert(vm->regfile[R10] == tcase.expect);
+    }
+}
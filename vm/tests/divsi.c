@@ -0,0 +1,21 @@
+
+void test_divsi()
+{
+    printf("test_divsi\n");
+
+    for (int i = 0; i < arrlen(divs_cases); ++i) {
+        struct divs_test_case tcase = divs_cases[i];
+
+        printf("    %s\n", tcase.title);
+        reset_vm();
+
+        vm->regfile[R10] = tcase.a;
+        divsi(tcase.b, R10);
+        halt();
+
+        vm->pc = 0;
+        vm_start(vm);
+
+        assert(vm->regfile[R10] == tcase.expect);
+    }
+}
@@ -0,0 +1,13 @@
+void test_ei()
+{
+    printf("test_ei\n");
+    reset_vm();
+
+    ei();
+    halt();
+
+    vm->pc = 0;
+    vm_start(vm);
+
+    assert(vm->flags[IF] == 1);
+}
@@ -0,0 +1,18 @@
+void test_enter()
+{
+    printf("test_enter\n");
+    reset_vm();
+
+    vm->regfile[RSP] = 0x2000;
+    vm->regfile[RBP] = 0x3000;
+
+    enter(8);
+    halt();
+
+    vm->pc = 0;
+    vm_start(vm);
+
+    assert(read_word(vm, 0x1ffe) == 0x3000);
+    assert(vm->regfile[RBP] == 0x1ffe);
+    assert(vm->regfile[RSP] == 0x1ffe - 8);
+}
@@ -0,0 +1,111 @@
+void test_file()
+{
+    struct file_window fw;
+    struct vm *m;
+    char path[] = "/tmp/vm-test-file-XXXXXX";
+    char line[512];
+    uint8_t data[3 * FILE_WINDOW_SIZE + 100], byte;
+    int fd, maps;
+    FILE *f;
+
+    printf("test_file\n");
+
+    for (int i = 0; i < (int) sizeof(data); ++i) {
+        data[i] = i * 7 + (i >> 8);
+    }
+
+    fd = mkstemp(path);
+    assert(fd >= 0);
+    assert(write(fd, data, sizeof(data)) == sizeof(data));
+    close(fd);
+
+    printf("    maps the start of the file\n");
+    reset_vm();
+    assert(file_attach(vm, &fw, path) == 0);
+
+    ldbi(FILE_WINDOW, R10);
+    ldi(FILE_WINDOW + 0x10, R11);
+    ldi(FILE_SIZE, R12);
+    halt();
+
+    vm->pc = 0;
+    vm_start(vm);
+
+    assert((vm->regfile[R10] & 0xff) == data[0]);
+    assert(vm->regfile[R11] == (data[0x11] << 8 | data[0x10]));
+    assert(vm->regfile[R12] == (uint16_t) sizeof(data));
+
+    file_detach(&fw);
+
+    printf("    moves the window\n");
+    reset_vm();
+    assert(file_attach(vm, &fw, path) == 0);
+
+    movi(2 * FILE_WINDOW_SIZE >> PAGE_BITS, R10);
+    sti(R10, FILE_OFFSET);
+    ldbi(FILE_WINDOW + 5, R11);
+    halt();
+
+    vm->pc = 0;
+    vm_start(vm);
+
+    assert((vm->regfile[R11] & 0xff) == data[2 * FILE_WINDOW_SIZE + 5]);
+
+    file_detach(&fw);
+
+    printf("    reads zero past the end of the file\n");
+    reset_vm();
+    assert(file_attach(vm, &fw, path) == 0);
+
+    movi(3 * FILE_WINDOW_SIZE >> PAGE_BITS, R10);
+    sti(R10, FILE_OFFSET);
+    ldi(FILE_WINDOW + 99, R11);
+    ldi(FILE_WINDOW + 200, R12);
+    halt();
+
+    vm->pc = 0;
+    vm_start(vm);
+
+    assert(vm->regfile[R11] == data[3 * FILE_WINDOW_SIZE + 99]);
+    assert(vm->regfile[R12] == 0);
+
+    file_detach(&fw);
+
+    printf("    ignores stores to the window\n");
+    reset_vm();
+    assert(file_attach(vm, &fw, path) == 0);
+
+    movi(0xffff, R10);
+    sti(R10, FILE_WINDOW);
+    ldi(FILE_WINDOW, R11);
+    halt();
+
+    vm->pc = 0;
+    vm_start(vm);
+
+    assert(vm->regfile[R11] == (data[1] << 8 | data[0]));
+
+    file_detach(&fw);
+
+    printf("    releases the old mapping when attached again\n");
+    m = vm_create();
+    assert(m != NULL);
+    assert(vm_attach_file(m, path) == 0);
+    assert(vm_attach_file(m, path) == 0);
+
+    vm_read(m, FILE_WINDOW + 1, &byte, 1);
+    assert(byte == data[1]);
+
+    f = fopen("/proc/self/maps", "r");
+    assert(f != NULL);
+    maps = 0;
+    while (fgets(line, sizeof(line), f) != NULL) {
+        maps += strstr(line, path) != NULL;
+    }
+    fclose(f);
+    assert(maps == 1);
+
+    vm_destroy(m);
+
+    unlink(path);
+}
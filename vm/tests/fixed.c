@@ -0,0 +1,105 @@
+// Sums 3 five times with a counted loop and a call.
+void write_fixed_loop()
+{
+    fixed(MOVI, R10, 0, 0);
+    fixed(MOVI, R11, 0, 5);
+    fixed(CALL, 0, 0, 0x40);
+    fixed(LOOP, R11, 0, -8);
+    fixed(HALT, 0, 0, 0);
+
+    vm->pc = 0x40;
+    fixed(ADDI, R10, 0, 3);
+    fixed(RET, 0, 0, 0);
+}
+
+void test_fixed()
+{
+    printf("test_fixed\n");
+
+    printf("    runs unverified image\n");
+    reset_vm();
+
+    vm->encoding = ENCODING_FIXED;
+    write_fixed_loop();
+
+    vm->pc = 0;
+    vm_start(vm);
+
+    assert(vm->regfile[R10] == 15);
+    assert(vm->regfile[R11] == 0);
+
+    printf("    runs verified image\n");
+    reset_vm();
+
+    vm->encoding = ENCODING_FIXED;
+    write_fixed_loop();
+
+    assert(verify_image(vm, 0) == 0);
+
+    vm->pc = 0;
+    vm_start(vm);
+
+    assert(vm->regfile[R10] == 15);
+
+    printf("    extra registers and conditions come from the immediate\n");
+    reset_vm();
+
+    vm->encoding = ENCODING_FIXED;
+    write_word(vm, 0xabcd, 0x1006);
+    vm->regfile[R1] = 0x1000;
+    vm->regfile[R2] = 3;
+    vm->regfile[R3] = 7;
+
+    fixed(LDX, R1, R2, 2 << 4 | R4);
+    fixed(BMOV, R1, R5, R2 << 4);
+    fixed(CMPI, R3, 0, 7);
+    fixed(SET, R6, 0, COND_E);
+    fixed(HALT, 0, 0, 0);
+
+    vm->regfile[R5] = 0x2000;
+    assert(verify_image(vm, 0) == 0);
+
+    vm->pc = 0;
+    vm_start(vm);
+
+    assert(vm->regfile[R4] == 0xabcd);
+    assert(memcmp(vm->ram + 0x1000, vm->ram + 0x2000, 3) == 0);
+    assert(vm->regfile[R6] == 1);
+
+    printf("    rejects misaligned jump\n");
+    reset_vm();
+
+    vm->encoding = ENCODING_FIXED;
+    fixed(JABS, 0, 0, 6);
+
+    assert(verify_image(vm, 0) == -1);
+
+    printf("    rejects invalid condition\n");
+    reset_vm();
+
+    vm->encoding = ENCODING_FIXED;
+    fixed(SET, R6, 0, 0x100 | COND_E);
+    fixed(HALT, 0, 0, 0);
+
+    assert(verify_image(vm, 0) == -1);
+
+    printf("    faults on return to a misaligned address\n");
+    reset_vm();
+
+    vm->encoding = ENCODING_FIXED;
+    fixed(PUSHI, 0, 0, 0x42);
+    fixed(RET, 0, 0, 0);
+
+    vm->pc = 0x40;
+    fixed(HALT, 0, 0, 0);
+    fixed(MOVI, R10, 0, 1);
+    fixed(HALT, 0, 0, 0);
+
+    assert(verify_image(vm, 0) == 0);
+
+    vm->pc = 0;
+    vm_start(vm);
+
+    assert(vm->regfile[R10] == 0);
+    assert(vm->pc == 0x42);
+}
@@ -0,0 +1,23 @@
+void test_iret()
+{
+    printf("test_iret\n");
+    reset_vm();
+
+    vm->regfile[RSP] = 0x1000 - 4;
+    write_word(vm, (1 << ZF) | (1 << IF), 0x1000 - 4);
+    write_word(vm, 69, 0x1000 - 2);
+
+    iret();
+
+    vm->pc = 69;
+    movi(1, R10);
+    halt();
+
+    vm->pc = 0;
+    vm_start(vm);
+
+    assert(vm->regfile[R10] == 1);
+    assert(vm->regfile[RSP] == 0x1000);
+    assert(vm->flags[ZF] == 1);
+    assert(vm->flags[IF] == 1);
+}
@@ -6,12 +6,12 @@ void test_jabs()
     jabs(69);
     halt();
 
-    pc = 69;
+    vm->pc = 69;
     movi(8, R10);
     halt();
 
-    pc = 0;
-    vm_start();
+    vm->pc = 0;
+    vm_start(vm);
 
-    assert(regfile[R10] == 8);
+    assert(vm->regfile[R10] == 8);
 }
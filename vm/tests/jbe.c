@@ -36,19 +36,19 @@ void test_jbe()
         printf("    %s\n", tcase.title);
         reset_vm();
 
-        regfile[R10] = tcase.a;
+        vm->regfile[R10] = tcase.a;
         cmpi(tcase.b, R10);
         jbe(69);
         movi(0, R10);
         halt();
 
-        pc = 69;
+        vm->pc = 69;
         movi(1, R10);
         halt();
 
-        pc = 0;
-        vm_start();
+        vm->pc = 0;
+        vm_start(vm);
 
-        assert(regfile[R10] == tcase.expect);
+        assert(vm->regfile[R10] == tcase.expect);
     }
 }
@@ -0,0 +1,102 @@
+struct jtab_test_case {
+    char *title;
+    uint16_t index;
+    uint16_t expect;
+};
+
+struct jtab_test_case jtab_cases[] = {
+    {
+        .title = "first entry",
+        .index = 0,
+        .expect = 10
+    },
+    {
+        .title = "last entry",
+        .index = 2,
+        .expect = 30
+    },
+    {
+        .title = "index past the end takes the default",
+        .index = 3,
+        .expect = 99
+    },
+    {
+        .title = "negative index takes the default",
+        .index = 0xffff,
+        .expect = 99
+    }
+};
+
+// Table at 0x1000 with three cases and a default, each setting R11.
+void write_jtab_image()
+{
+    uint16_t targets[] = {0x200, 0x210, 0x220, 0x230};
+    uint16_t values[] = {99, 10, 20, 30};
+
+    write_word(vm, 3, 0x1000);
+    for (int i = 0; i < 4; ++i) {
+        write_word(vm, targets[i], 0x1002 + 2 * i);
+        vm->pc = targets[i];
+        movi(values[i], R11);
+        halt();
+    }
+}
+
+void test_jtab()
+{
+    printf("test_jtab\n");
+
+    for (int i = 0; i < arrlen(jtab_cases); ++i) {
+        struct jtab_test_case tcase = jtab_cases[i];
+
+        printf("    %s\n", tcase.title);
+        reset_vm();
+
+        write_jtab_image();
+
+        vm->pc = 0;
+        vm->regfile[R10] = tcase.index;
+        jtab(R10, 0x1000);
+
+        assert(verify_image(vm, 0) == 0);
+
+        vm->pc = 0;
+        vm_start(vm);
+
+        assert(vm->regfile[R11] == tcase.expect);
+    }
+
+    printf("    rejects table target into the middle of an instruction\n");
+    reset_vm();
+
+    write_jtab_image();
+    write_word(vm, 0x211, 0x1006);
+
+    vm->pc = 0;
+    jtab(R10, 0x1000);
+
+    assert(verify_image(vm, 0) == -1);
+
+    printf("    leaves unchecked mode when the table was changed\n");
+    reset_vm();
+
+    write_jtab_image();
+
+    vm->pc = 0;
+    movi(0x300, R12);
+    sti(R12, 0x1006);
+    vm->regfile[R10] = 1;
+    jtab(R10, 0x1000);
+
+    vm->pc = 0x300;
+    movi(1, 0xff);
+    movi(5, R11);
+    halt();
+
+    assert(verify_image(vm, 0) == 0);
+
+    vm->pc = 0;
+    vm_start(vm);
+
+    assert(vm->regfile[R11] == 0);
+}
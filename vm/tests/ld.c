@@ -3,14 +3,28 @@ void test_ld()
     printf("test_ld\n");
     reset_vm();
 
-    write_word(0xabcd, 100);
-    regfile[R10] = 100;
+    write_word(vm, 0xabcd, 100);
+    vm->regfile[R10] = 100;
 
     ld(R10, R11);
     halt();
 
-    pc = 0;
-    vm_start();
+    vm->pc = 0;
+    vm_start(vm);
 
-    assert(regfile[R11] == 0xabcd);
+    assert(vm->regfile[R11] == 0xabcd);
+
+    printf("    wraps around the end of ram\n");
+    reset_vm();
+
+    write_byte(vm, 0xcd, 0xffff);
+    vm->regfile[R10] = 0xffff;
+
+    ld(R10, R11);
+    halt();
+
+    vm->pc = 0;
+    vm_start(vm);
+
+    assert(vm->regfile[R11] == ((LD << 8) | 0xcd));
 }
@@ -0,0 +1,17 @@
+void test_ldbd()
+{
+    printf("test_ldbd\n");
+    reset_vm();
+
+    write_byte(vm, 0x80, 0x1ffe);
+    vm->regfile[RBP] = 0x2000;
+    vm->regfile[R11] = 0xabcd;
+
+    ldbd(RBP, R11, -2);
+    halt();
+
+    vm->pc = 0;
+    vm_start(vm);
+
+    assert(vm->regfile[R11] == 0xab80);
+}
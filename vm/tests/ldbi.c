@@ -3,15 +3,15 @@ void test_ldbi()
     printf("test_ldbi\n");
     reset_vm();
 
-    write_byte(0x80, 100);
-    regfile[R10] = 0xabcd;
+    write_byte(vm, 0x80, 100);
+    vm->regfile[R10] = 0xabcd;
 
     ldbi(100, R10);
     halt();
 
-    pc = 0;
-    vm_start();
+    vm->pc = 0;
+    vm_start(vm);
 
-    assert(regfile[R10] == 0xab80);
+    assert(vm->regfile[R10] == 0xab80);
 }
 
@@ -0,0 +1,18 @@
+void test_ldbx()
+{
+    printf("test_ldbx\n");
+    reset_vm();
+
+    write_byte(vm, 0x80, 0x1010);
+    vm->regfile[R10] = 0x1000;
+    vm->regfile[R11] = 4;
+    vm->regfile[R12] = 0xabcd;
+
+    ldbx(R10, R11, 4, R12);
+    halt();
+
+    vm->pc = 0;
+    vm_start(vm);
+
+    assert(vm->regfile[R12] == 0xab80);
+}
@@ -0,0 +1,47 @@
+void test_ldd()
+{
+    printf("test_ldd\n");
+
+    printf("    positive displacement\n");
+    reset_vm();
+
+    write_word(vm, 0xabcd, 0x1006);
+    vm->regfile[R10] = 0x1000;
+
+    ldd(R10, R11, 6);
+    halt();
+
+    vm->pc = 0;
+    vm_start(vm);
+
+    assert(vm->regfile[R11] == 0xabcd);
+
+    printf("    negative displacement from the frame pointer\n");
+    reset_vm();
+
+    write_word(vm, 0x1234, 0x1ffc);
+    vm->regfile[RBP] = 0x2000;
+
+    ldd(RBP, R11, -4);
+    halt();
+
+    vm->pc = 0;
+    vm_start(vm);
+
+    assert(vm->regfile[R11] == 0x1234);
+
+    printf("    address wraps around\n");
+    reset_vm();
+
+    write_word(vm, 0x5678, 0x0800);
+    vm->regfile[R10] = 0xf000;
+
+    vm->pc = 0x100;
+    ldd(R10, R11, 0x1800);
+    halt();
+
+    vm->pc = 0x100;
+    vm_start(vm);
+
+    assert(vm->regfile[R11] == 0x5678);
+}
@@ -3,14 +3,14 @@ void test_ldi()
     printf("test_ldi\n");
     reset_vm();
 
-    write_word(0xabcd, 100);
+    write_word(vm, 0xabcd, 100);
 
     ldi(100, R10);
     halt();
 
-    pc = 0;
-    vm_start();
+    vm->pc = 0;
+    vm_start(vm);
 
-    assert(regfile[R10] == 0xabcd);
+    assert(vm->regfile[R10] == 0xabcd);
 }
 
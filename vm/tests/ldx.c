@@ -0,0 +1,62 @@
+struct ldx_test_case {
+    char *title;
+    uint16_t base;
+    uint16_t index;
+    uint8_t scale;
+    uint16_t addr;
+};
+
+struct ldx_test_case ldx_cases[] = {
+    {
+        .title = "byte scale",
+        .base = 0x1000,
+        .index = 7,
+        .scale = 1,
+        .addr = 0x1007
+    },
+    {
+        .title = "word scale",
+        .base = 0x1000,
+        .index = 7,
+        .scale = 2,
+        .addr = 0x100e
+    },
+    {
+        .title = "record scale",
+        .base = 0x1000,
+        .index = 3,
+        .scale = 12,
+        .addr = 0x1024
+    },
+    {
+        .title = "zero scale ignores the index",
+        .base = 0x1000,
+        .index = 3,
+        .scale = 0,
+        .addr = 0x1000
+    }
+};
+
+void test_ldx()
+{
+    printf("test_ldx\n");
+
+    for (int i = 0; i < arrlen(ldx_cases); ++i) {
+        struct ldx_test_case tcase = ldx_cases[i];
+
+        printf("    %s\n", tcase.title);
+        reset_vm();
+
+        write_word(vm, 0xabcd, tcase.addr);
+        vm->regfile[R10] = tcase.base;
+        vm->regfile[R11] = tcase.index;
+
+        ldx(R10, R11, tcase.scale, R12);
+        halt();
+
+        vm->pc = 0;
+        vm_start(vm);
+
+        assert(vm->regfile[R12] == 0xabcd);
+    }
+}
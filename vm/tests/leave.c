@@ -0,0 +1,26 @@
+void test_leave()
+{
+    printf("test_leave\n");
+    reset_vm();
+
+    vm->regfile[RSP] = 0x2000;
+    vm->regfile[RBP] = 0x3000;
+
+    call(69);
+    halt();
+
+    vm->pc = 69;
+    enter(8);
+    movi(0x1234, R10);
+    std(R10, RBP, -2);
+    ldd(RBP, R11, -2);
+    leave();
+    ret();
+
+    vm->pc = 0;
+    vm_start(vm);
+
+    assert(vm->regfile[R11] == 0x1234);
+    assert(vm->regfile[RSP] == 0x2000);
+    assert(vm->regfile[RBP] == 0x3000);
+}
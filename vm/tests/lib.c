@@ -0,0 +1,294 @@
+void capture_log(void *arg, const char *msg)
+{
+    snprintf(arg, 64, "%s", msg);
+}
+
+void *run_lib_thread(void *arg)
+{
+    return (void *) (long) vm_run(arg, -1);
+}
+
+// Images are assembled in the test machine and loaded into new ones.
+void test_lib()
+{
+    uint8_t code[0x1000], buf[4];
+    char log[64];
+    int len, handler_len, wait_len, fixed_len, count_len, console_len, send_len;
+    int top, got;
+    int fds[2];
+    struct vm *a, *b, *many[4], *receiver;
+    pthread_t threads[4];
+    struct vm_channel *ch, *ch2;
+    enum vm_status sa, sb;
+
+    printf("test_lib\n");
+
+    reset_vm();
+    movi(0, R10);
+    addi(1, R10);
+    cmpi(3, R10);
+    jne(4);
+    syscall(1);
+    st(R10, R11);
+    halt();
+    len = vm->pc;
+
+    vm->pc = 0x100;
+    movi(7, R12);
+    iret();
+    handler_len = vm->pc - 0x100;
+
+    vm->pc = 0x800;
+    ei();
+    wait();
+    movi(1, R10);
+    halt();
+    wait_len = vm->pc - 0x800;
+
+    vm->encoding = ENCODING_FIXED;
+    vm->pc = 0x400;
+    movi(5, R10);
+    syscall(9);
+    halt();
+    fixed_len = vm->pc - 0x400;
+
+    // Sends 1, 2 and 3 on endpoint 0, retrying while the queue is full.
+    vm->encoding = ENCODING_VARIABLE;
+    vm->pc = 0xa00;
+    movi(0, R10);
+    for (int i = 1; i <= 3; ++i) {
+        top = vm->pc;
+        movbi(i, R8);
+        stbi(R8, 0x200);
+        write_channel_send(1);
+        cmpi(1, R13);
+        jne(top);
+    }
+    halt();
+
+    // Adds three messages from endpoint 0 into R9. Interrupts are off
+    // between an empty receive and WAIT so a message cannot slip in
+    // between, EI then takes the interrupt that woke it.
+    vm->pc = 0xc00;
+    movi(3, R7);
+    top = vm->pc;
+    di();
+    movi(0, R10);
+    write_channel_receive(1);
+    cmpi(1, R13);
+    got = vm->pc;
+    je(0);
+    wait();
+    ei();
+    jabs(top);
+    write_word(vm, vm->pc, got + 1);
+    ldbi(0x300, R6);
+    add(R6, R9);
+    subfi(1, R7);
+    jne(top);
+    halt();
+
+    vm->pc = 0xe00;
+    iret();
+
+    // Sends 4 on endpoint 0 once.
+    vm->pc = 0x900;
+    movi(0, R10);
+    movbi(4, R8);
+    stbi(R8, 0x200);
+    write_channel_send(1);
+    halt();
+    send_len = vm->pc - 0x900;
+
+    // Counts R10 to 50000 and stores it at R11.
+    vm->pc = 0x600;
+    movi(0, R10);
+    top = vm->pc;
+    addi(1, R10);
+    cmpi(50000, R10);
+    jne(top);
+    st(R10, R11);
+    halt();
+    count_len = vm->pc - 0x600;
+
+    // Puts one byte in the console ring without flushing it.
+    vm->pc = 0x700;
+    movbi('x', R8);
+    stbi(R8, CONSOLE_RING);
+    movi(1, R9);
+    sti(R9, CONSOLE_TAIL);
+    syscall(0);
+    console_len = vm->pc - 0x700;
+
+    memcpy(code, vm->ram, sizeof(code));
+
+    a = vm_create();
+    b = vm_create();
+    assert(a != NULL && b != NULL);
+
+    printf("    runs to halt\n");
+    assert(vm_load(a, 0, code, len, ENCODING_VARIABLE) == 0);
+    vm_set_register(a, R11, 0x100);
+    assert(vm_run(a, -1) == VM_SYSCALL);
+    assert(vm_syscall_number(a) == 1);
+    assert(vm_exit_pc(a) == 15);
+    assert(vm_get_register(a, R10) == 3);
+    assert(vm_run(a, -1) == VM_HALTED);
+    vm_read(a, 0x100, buf, 2);
+    assert(buf[0] == 3 && buf[1] == 0);
+
+    printf("    stops when the budget runs out\n");
+    assert(vm_load(b, 0, code, len, ENCODING_VARIABLE) == 0);
+    assert(vm_run(b, 5) == VM_BUDGET);
+    assert(vm_get_pc(b) == 8);
+    assert(vm_get_register(b, R10) == 2);
+    assert(vm_run(b, 0) == VM_BUDGET);
+    assert(vm_get_pc(b) == 8);
+
+    printf("    steps one instruction at a time\n");
+    assert(vm_step(b) == VM_BUDGET);
+    assert(vm_get_pc(b) == 12);
+    assert(vm_get_register(b, R10) == 2);
+
+    printf("    keeps instances apart\n");
+    assert(vm_get_register(a, R10) == 3);
+    assert(vm_get_register(b, R10) == 2);
+    vm_write(b, 0x100, "\x55\xaa", 2);
+    vm_read(a, 0x100, buf, 2);
+    assert(buf[0] == 3);
+    vm_read(b, 0x100, buf, 2);
+    assert(buf[0] == 0x55 && buf[1] == 0xaa);
+
+    printf("    resumes checked off verified code\n");
+    vm_write(b, 0x300, (uint8_t[]) {MOVI, 1, 0, 0xff}, 4);
+    vm_set_pc(b, 0x300);
+    assert(vm_step(b) == VM_FAULT);
+    assert(vm_exit_pc(b) == 0x300);
+
+    printf("    reports the faulting instruction\n");
+    vm_set_log(b, capture_log, log);
+    assert(vm_load(b, 0x200, (uint8_t[]) {0xff}, 1, ENCODING_VARIABLE) == 0);
+    assert(strcmp(log, "verify: unknown opcode `ff` at ram[512]") == 0);
+    assert(vm_run(b, -1) == VM_FAULT);
+    assert(vm_exit_pc(b) == 0x200);
+    assert(strcmp(log, "unknown opcode `ff` at ram[512]") == 0);
+    vm_set_log(b, NULL, NULL);
+
+    printf("    runs fixed images\n");
+    assert(vm_load(a, 0x400, code + 0x400, fixed_len, ENCODING_FIXED) == 0);
+    assert(vm_run(a, -1) == VM_SYSCALL);
+    assert(vm_syscall_number(a) == 9);
+    assert(vm_exit_pc(a) == 0x404);
+    assert(vm_get_register(a, R10) == 5);
+
+    printf("    wakes a waiting machine\n");
+    assert(vm_load(a, 0x100, code + 0x100, handler_len, ENCODING_VARIABLE) == 0);
+    assert(vm_load(a, 0x800, code + 0x800, wait_len, ENCODING_VARIABLE) == 0);
+    vm_write(a, INTERRUPT_VECTORS + 2, (uint8_t[]) {0x00, 0x01}, 2);
+
+    assert(vm_run(a, -1) == VM_WAITING);
+    assert(vm_run(a, -1) == VM_WAITING);
+    assert(vm_raise(a, 1) == 1);
+    assert(vm_raise(a, 1) == 0);
+    assert(vm_raise(a, INTERRUPT_COUNT) == -1);
+    assert(vm_run(a, -1) == VM_HALTED);
+    assert(vm_get_register(a, R12) == 7);
+    assert(vm_get_register(a, R10) == 1);
+
+    printf("    passes messages between machines\n");
+    ch = vm_channel_create(2, 1);
+    assert(ch != NULL);
+    assert(vm_attach_channel(a, 0, ch, 0) == 0);
+    assert(vm_attach_channel(b, 0, ch, 1) == 0);
+    assert(vm_attach_channel(b, CHANNEL_COUNT, ch, 1) == -1);
+    assert(vm_load(a, 0xa00, code + 0xa00, 0x200, ENCODING_VARIABLE) == 0);
+    assert(vm_load(b, 0xe00, code + 0xe00, 1, ENCODING_VARIABLE) == 0);
+    assert(vm_load(b, 0xc00, code + 0xc00, 0x200, ENCODING_VARIABLE) == 0);
+    vm_write(b, INTERRUPT_VECTORS + 2 * INTERRUPT_CHANNEL, (uint8_t[]) {0x00, 0x0e}, 2);
+
+    sa = sb = VM_BUDGET;
+    for (int i = 0; i < 1000 && (sa != VM_HALTED || sb != VM_HALTED); ++i) {
+        if (sb != VM_HALTED) {
+            sb = vm_run(b, 7);
+        }
+        if (sa != VM_HALTED) {
+            sa = vm_run(a, 7);
+        }
+    }
+
+    assert(sa == VM_HALTED && sb == VM_HALTED);
+    assert(vm_get_register(b, R9) == 6);
+
+    printf("    reports the receiver a send woke\n");
+    ch2 = vm_channel_create(2, 1);
+    assert(ch2 != NULL);
+    receiver = vm_create();
+    many[0] = vm_create();
+    assert(receiver != NULL && many[0] != NULL);
+    assert(vm_attach_channel(receiver, 0, ch2, 1) == 0);
+    assert(vm_attach_channel(many[0], 0, ch2, 0) == 0);
+    assert(vm_load(receiver, 0xe00, code + 0xe00, 1, ENCODING_VARIABLE) == 0);
+    assert(vm_load(receiver, 0xc00, code + 0xc00, 0x200, ENCODING_VARIABLE) == 0);
+    vm_write(receiver, INTERRUPT_VECTORS + 2 * INTERRUPT_CHANNEL, (uint8_t[]) {0x00, 0x0e}, 2);
+    assert(vm_load(many[0], 0x900, code + 0x900, send_len, ENCODING_VARIABLE) == 0);
+
+    assert(vm_run(receiver, -1) == VM_WAITING);
+    assert(vm_channel_send(ch2, (uint8_t[]) {1}, 1) == 1);
+    assert(vm_channel_send(ch2, (uint8_t[]) {2}, 1) == 0);
+    assert(vm_run(receiver, -1) == VM_WAITING);
+    assert(vm_run(receiver, -1) == VM_WAITING);
+    assert(vm_get_register(receiver, R9) == 3);
+
+    assert(vm_run(many[0], -1) == VM_HALTED);
+    assert(vm_get_register(many[0], R13) == 1);
+    assert(vm_woken(many[0]) == receiver);
+    assert(vm_woken(many[0]) == NULL);
+    assert(vm_run(receiver, -1) == VM_HALTED);
+    assert(vm_get_register(receiver, R9) == 7);
+
+    vm_destroy(receiver);
+    vm_destroy(many[0]);
+    vm_channel_destroy(ch2);
+
+    printf("    runs machines on separate threads\n");
+    for (int i = 0; i < 4; ++i) {
+        many[i] = vm_create();
+        assert(many[i] != NULL);
+        assert(vm_load(many[i], 0x600, code + 0x600, count_len, ENCODING_VARIABLE) == 0);
+        vm_set_register(many[i], R11, 0x2000 + 2 * i);
+    }
+    for (int i = 0; i < 4; ++i) {
+        assert(pthread_create(&threads[i], NULL, run_lib_thread, many[i]) == 0);
+    }
+    for (int i = 0; i < 4; ++i) {
+        void *status;
+
+        assert(pthread_join(threads[i], &status) == 0);
+        assert((long) status == VM_HALTED);
+        assert(vm_get_register(many[i], R10) == 50000);
+        vm_read(many[i], 0x2000 + 2 * i, buf, 2);
+        assert(buf[0] == (50000 & 0xff) && buf[1] == 50000 >> 8);
+        vm_read(many[i], 0x2000 + 2 * ((i + 1) % 4), buf, 2);
+        assert(buf[0] == 0 && buf[1] == 0);
+        vm_destroy(many[i]);
+    }
+
+    printf("    flushes the console when destroyed\n");
+    many[0] = vm_create();
+    assert(many[0] != NULL);
+    assert(pipe(fds) == 0);
+    assert(vm_attach_console(many[0], fds[1]) == 0);
+    assert(vm_load(many[0], 0x700, code + 0x700, console_len, ENCODING_VARIABLE) == 0);
+    assert(vm_run(many[0], -1) == VM_SYSCALL);
+    vm_destroy(many[0]);
+    close(fds[1]);
+    assert(read(fds[0], buf, sizeof(buf)) == 1 && buf[0] == 'x');
+    close(fds[0]);
+
+    printf("    rejects images that do not fit\n");
+    assert(vm_load(a, 0xfff0, code, 32, ENCODING_VARIABLE) != 0);
+
+    vm_destroy(a);
+    vm_destroy(b);
+    vm_channel_destroy(ch);
+}
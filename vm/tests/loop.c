@@ -0,0 +1,40 @@
+void test_loop()
+{
+    printf("test_loop\n");
+
+    printf("    runs the body count times\n");
+    reset_vm();
+
+    vm->regfile[R10] = 5;
+    movi(0, R11);
+    addi(3, R11);
+    loop(R10, 4);
+    halt();
+
+    assert(verify_image(vm, 0) == 0);
+
+    vm->pc = 0;
+    vm_start(vm);
+
+    assert(vm->regfile[R11] == 15);
+    assert(vm->regfile[R10] == 0);
+
+    printf("    leaves the flags alone\n");
+    reset_vm();
+
+    vm->regfile[R10] = 2;
+    vm->regfile[R11] = 5;
+    cmpi(5, R11);
+    loop(R10, 0x1000);
+    halt();
+
+    vm->pc = 0x1000;
+    movi(1, R12);
+    halt();
+
+    vm->pc = 0;
+    vm_start(vm);
+
+    assert(vm->regfile[R12] == 1);
+    assert(vm->flags[ZF] == 1);
+}
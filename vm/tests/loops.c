@@ -0,0 +1,35 @@
+void test_loops()
+{
+    printf("test_loops\n");
+
+    printf("    runs the body count times\n");
+    reset_vm();
+
+    vm->regfile[R10] = 4;
+    movi(0, R11);
+    addi(2, R11);
+    loops(R10, 4);
+    halt();
+
+    assert(verify_image(vm, 0) == 0);
+
+    vm->pc = 0;
+    vm_start(vm);
+
+    assert(vm->regfile[R11] == 8);
+
+    printf("    counter of one falls through\n");
+    reset_vm();
+
+    vm->regfile[R10] = 1;
+    movi(0, R11);
+    addi(2, R11);
+    loops(R10, 4);
+    halt();
+
+    vm->pc = 0;
+    vm_start(vm);
+
+    assert(vm->regfile[R11] == 2);
+    assert(vm->regfile[R10] == 0);
+}
@@ -1,94 +1,229 @@
 #include <assert.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdarg.h>
+#include <stdlib.h>
+
+// The machine the tests assemble into and run.
+struct vm *vm;
+
+// Zeroes ram by handing the pages back to the kernel instead of touching
+// every one of them.
+static void ram_clear(struct vm *vm)
+{
+    madvise(vm->ram, RAM_CAP, MADV_DONTNEED);
+}
+
+// Unmaps every device.
+static void bus_reset(struct vm *vm)
+{
+    memset(vm->page_device, 0, sizeof(vm->page_device));
+    memset(vm->word_device, 0, sizeof(vm->word_device));
+}
 
 void reset_vm()
 {
-    memset(ram, 0, sizeof(ram));
-    memset(regfile, 0, sizeof(regfile));
-    memset(&flags, 0, sizeof(flags));
-    pc = 0;
+    ram_clear(vm);
+    bus_reset(vm);
+    bank_reset(vm);
+    memset(vm->regfile, 0, sizeof(vm->regfile));
+    memset(&vm->flags, 0, sizeof(vm->flags));
+    vm->pc = 0;
+    vm->verified = 0;
+    vm->encoding = ENCODING_VARIABLE;
+    vm->timer = NULL;
+    vm->interrupts = 0;
+}
+
+// Encodes op at pc in the current encoding. Operands come in encoding
+// order, as listed by its layout.
+void emit(enum vm_opcode op, ...)
+{
+    uint16_t operands[4];
+    va_list ap;
+
+    va_start(ap, op);
+    for (int i = 0; i < operand_count(op); ++i) {
+        operands[i] = va_arg(ap, int);
+    }
+    va_end(ap);
+
+    vm->pc += encode_instruction(vm, vm->pc, op, operands);
 }
 
 #define arrlen(arr) (sizeof((arr)) / sizeof(*(arr)))
 #define encode_registers(r1, r2) ((r1) << 4) | ((r2) & 0x0f)
 
-#define halt() write_byte(HALT, pc++)
-
-#define mov(r1, r2) write_byte(MOV, pc++), write_byte(encode_registers((r1), (r2)), pc++)
-#define movi(imm, r) write_byte(MOVI, pc++), write_word((imm), pc++), pc++, write_byte((r), pc++)
-#define movb(r1, r2) write_byte(MOVB, pc++), write_byte(encode_registers((r1), (r2)), pc++)
-#define movbi(imm, r) write_byte(MOVBI, pc++), write_byte((imm), pc++), write_byte((r), pc++)
-#define movze(r1, r2) write_byte(MOVZE, pc++), write_byte(encode_registers((r1), (r2)), pc++)
-#define movse(r1, r2) write_byte(MOVSE, pc++), write_byte(encode_registers((r1), (r2)), pc++)
-
-#define st(r1, r2) write_byte(ST, pc++), write_byte(encode_registers((r1), (r2)), pc++)
-#define sti(r, imm) write_byte(STI, pc++), write_byte((r), pc++), write_word((imm), pc++), pc++
-#define stb(r1, r2) write_byte(STB, pc++), write_byte(encode_registers((r1), (r2)), pc++)
-#define stbi(r, imm) write_byte(STBI, pc++), write_byte((r), pc++), write_word((imm), pc++), pc++
-#define ld(r1, r2) write_byte(LD, pc++), write_byte(encode_registers((r1), (r2)), pc++)
-#define ldi(imm, r) write_byte(LDI, pc++), write_word((imm), pc++), pc++, write_byte((r), pc++)
-#define ldb(r1, r2) write_byte(LDB, pc++), write_byte(encode_registers((r1), (r2)), pc++)
-#define ldbi(imm, r) write_byte(LDBI, pc++), write_word((imm), pc++), pc++, write_byte((r), pc++)
-
-#define add(r1, r2) write_byte(ADD, pc++), write_byte(encode_registers((r1), (r2)), pc++)
-#define addi(imm, r) write_byte(ADDI, pc++), write_word((imm), pc++), pc++, write_byte((r), pc++)
-#define addb(r1, r2) write_byte(ADDB, pc++), write_byte(encode_registers((r1), (r2)), pc++)
-#define addbi(imm, r) write_byte(ADDBI, pc++), write_byte((imm), pc++), write_byte((r), pc++)
-#define sub(r1, r2) write_byte(SUB, pc++), write_byte(encode_registers((r1), (r2)), pc++)
-#define subi(imm, r) write_byte(SUBI, pc++), write_word((imm), pc++), pc++, write_byte((r), pc++)
-#define subb(r1, r2) write_byte(SUBB, pc++), write_byte(encode_registers((r1), (r2)), pc++)
-#define subbi(imm, r) write_byte(SUBBI, pc++), write_byte((imm), pc++), write_byte((r), pc++)
-
-#define not(r) write_byte(NOT, pc++), write_byte((r), pc++)
-#define notb(r) write_byte(NOTB, pc++), write_byte((r), pc++)
-#define and(r1, r2) write_byte(AND, pc++), write_byte(encode_registers((r1), (r2)), pc++)
-#define andi(imm, r) write_byte(ANDI, pc++), write_word((imm), pc++), pc++, write_byte((r), pc++)
-#define andb(r1, r2) write_byte(ANDB, pc++), write_byte(encode_registers((r1), (r2)), pc++)
-#define andbi(imm, r) write_byte(ANDBI, pc++), write_byte((imm), pc++), write_byte((r), pc++)
-#define or(r1, r2) write_byte(OR, pc++), write_byte(encode_registers((r1), (r2)), pc++)
-#define ori(imm, r) write_byte(ORI, pc++), write_word((imm), pc++), pc++, write_byte((r), pc++)
-#define orb(r1, r2) write_byte(ORB, pc++), write_byte(encode_registers((r1), (r2)), pc++)
-#define orbi(imm, r) write_byte(ORBI, pc++), write_byte((imm), pc++), write_byte((r), pc++)
-#define xor(r1, r2) write_byte(XOR, pc++), write_byte(encode_registers((r1), (r2)), pc++)
-#define xori(imm, r) write_byte(XORI, pc++), write_word((imm), pc++), pc++, write_byte((r), pc++)
-#define xorb(r1, r2) write_byte(XORB, pc++), write_byte(encode_registers((r1), (r2)), pc++)
-#define xorbi(imm, r) write_byte(XORBI, pc++), write_byte((imm), pc++), write_byte((r), pc++)
-
-#define shl(r1, r2) write_byte(SHL, pc++), write_byte(encode_registers((r1), (r2)), pc++)
-#define shli(imm, r) write_byte(SHLI, pc++), write_byte((imm), pc++), write_byte((r), pc++)
-#define shlb(r1, r2) write_byte(SHLB, pc++), write_byte(encode_registers((r1), (r2)), pc++)
-#define shlbi(imm, r) write_byte(SHLBI, pc++), write_byte((imm), pc++), write_byte((r), pc++)
-#define shr(r1, r2) write_byte(SHR, pc++), write_byte(encode_registers((r1), (r2)), pc++)
-#define shri(imm, r) write_byte(SHRI, pc++), write_byte((imm), pc++), write_byte((r), pc++)
-#define shrb(r1, r2) write_byte(SHRB, pc++), write_byte(encode_registers((r1), (r2)), pc++)
-#define shrbi(imm, r) write_byte(SHRBI, pc++), write_byte((imm), pc++), write_byte((r), pc++)
-#define shra(r1, r2) write_byte(SHRA, pc++), write_byte(encode_registers((r1), (r2)), pc++)
-#define shrai(imm, r) write_byte(SHRAI, pc++), write_byte((imm), pc++), write_byte((r), pc++)
-#define shrab(r1, r2) write_byte(SHRAB, pc++), write_byte(encode_registers((r1), (r2)), pc++)
-#define shrabi(imm, r) write_byte(SHRABI, pc++), write_byte((imm), pc++), write_byte((r), pc++)
-
-#define cmp(r1, r2) write_byte(CMP, pc++), write_byte(encode_registers((r1), (r2)), pc++)
-#define cmpi(imm, r) write_byte(CMPI, pc++), write_word((imm), pc++), pc++, write_byte((r), pc++)
-#define cmpb(r1, r2) write_byte(CMPB, pc++), write_byte(encode_registers((r1), (r2)), pc++)
-#define cmpbi(imm, r) write_byte(CMPBI, pc++), write_byte((imm), pc++), write_byte((r), pc++)
-
-#define jabs(imm) write_byte(JABS, pc++), write_word((imm), pc++), pc++
-#define je(imm) write_byte(JE, pc++), write_word((imm), pc++), pc++
-#define jne(imm) write_byte(JNE, pc++), write_word((imm), pc++), pc++
-#define jg(imm) write_byte(JG, pc++), write_word((imm), pc++), pc++
-#define jge(imm) write_byte(JGE, pc++), write_word((imm), pc++), pc++
-#define jl(imm) write_byte(JL, pc++), write_word((imm), pc++), pc++
-#define jle(imm) write_byte(JLE, pc++), write_word((imm), pc++), pc++
-#define ja(imm) write_byte(JA, pc++), write_word((imm), pc++), pc++
-#define jae(imm) write_byte(JAE, pc++), write_word((imm), pc++), pc++
-#define jb(imm) write_byte(JB, pc++), write_word((imm), pc++), pc++
-#define jbe(imm) write_byte(JBE, pc++), write_word((imm), pc++), pc++
-
-#define push(r) write_byte(PUSH, pc++), write_byte((r), pc++)
-#define pushi(imm) write_byte(PUSHI, pc++), write_word((imm), pc++), pc++
-#define pop(r) write_byte(POP, pc++), write_byte((r), pc++)
-#define call(imm) write_byte(CALL, pc++), write_word((imm), pc++), pc++
-#define callr(r) write_byte(CALLR, pc++), write_byte((r), pc++)
-#define ret() write_byte(RET, pc++)
+#define halt() emit(HALT)
+
+// One instruction in the fixed encoding. Third and fourth registers and
+// conditions go in imm.
+#define fixed(op, r1, r2, imm) write_byte(vm, (op), vm->pc), write_byte(vm, encode_registers((r1), (r2)), vm->pc + 1), write_word(vm, (imm), vm->pc + 2), vm->pc += 4
+
+#define mov(r1, r2) emit(MOV, (r1), (r2))
+#define movi(imm, r) emit(MOVI, (imm), (r))
+#define movb(r1, r2) emit(MOVB, (r1), (r2))
+#define movbi(imm, r) emit(MOVBI, (imm), (r))
+#define movze(r1, r2) emit(MOVZE, (r1), (r2))
+#define movse(r1, r2) emit(MOVSE, (r1), (r2))
+#define cmov(cond, r1, r2) emit(CMOV, (cond), (r1), (r2))
+#define set(cond, r) emit(SET, (cond), (r))
+
+#define st(r1, r2) emit(ST, (r1), (r2))
+#define sti(r, imm) emit(STI, (r), (imm))
+#define stb(r1, r2) emit(STB, (r1), (r2))
+#define stbi(r, imm) emit(STBI, (r), (imm))
+#define ld(r1, r2) emit(LD, (r1), (r2))
+#define ldi(imm, r) emit(LDI, (imm), (r))
+#define ldb(r1, r2) emit(LDB, (r1), (r2))
+#define ldbi(imm, r) emit(LDBI, (imm), (r))
+#define std(r1, r2, disp) emit(STD, (r1), (r2), (disp))
+#define stbd(r1, r2, disp) emit(STBD, (r1), (r2), (disp))
+#define ldd(r1, r2, disp) emit(LDD, (r1), (r2), (disp))
+#define ldbd(r1, r2, disp) emit(LDBD, (r1), (r2), (disp))
+#define stx(base, index, scale, r) emit(STX, (base), (index), (scale), (r))
+#define stbx(base, index, scale, r) emit(STBX, (base), (index), (scale), (r))
+#define ldx(base, index, scale, r) emit(LDX, (base), (index), (scale), (r))
+#define ldbx(base, index, scale, r) emit(LDBX, (base), (index), (scale), (r))
+#define bmov(r1, r2, r3) emit(BMOV, (r1), (r2), (r3))
+#define bfill(r1, r2, r3) emit(BFILL, (r1), (r2), (r3))
+#define bcmp(r1, r2, r3) emit(BCMP, (r1), (r2), (r3))
+#define scanb(r1, r2, r3, r4) emit(SCANB, (r1), (r2), (r3), (r4))
+#define mismatch(r1, r2, r3, r4) emit(MISMATCH, (r1), (r2), (r3), (r4))
+#define strnlen(r1, r2, r3) emit(STRNLEN, (r1), (r2), (r3))
+
+#define add(r1, r2) emit(ADD, (r1), (r2))
+#define addi(imm, r) emit(ADDI, (imm), (r))
+#define addb(r1, r2) emit(ADDB, (r1), (r2))
+#define addbi(imm, r) emit(ADDBI, (imm), (r))
+#define sub(r1, r2) emit(SUB, (r1), (r2))
+#define subi(imm, r) emit(SUBI, (imm), (r))
+#define subb(r1, r2) emit(SUBB, (r1), (r2))
+#define subbi(imm, r) emit(SUBBI, (imm), (r))
+
+#define addf(r1, r2) emit(ADDF, (r1), (r2))
+#define addfi(imm, r) emit(ADDFI, (imm), (r))
+#define addfb(r1, r2) emit(ADDFB, (r1), (r2))
+#define addfbi(imm, r) emit(ADDFBI, (imm), (r))
+#define subf(r1, r2) emit(SUBF, (r1), (r2))
+#define subfi(imm, r) emit(SUBFI, (imm), (r))
+#define subfb(r1, r2) emit(SUBFB, (r1), (r2))
+#define subfbi(imm, r) emit(SUBFBI, (imm), (r))
+#define adc(r1, r2) emit(ADC, (r1), (r2))
+#define adci(imm, r) emit(ADCI, (imm), (r))
+#define adcb(r1, r2) emit(ADCB, (r1), (r2))
+#define adcbi(imm, r) emit(ADCBI, (imm), (r))
+#define sbb(r1, r2) emit(SBB, (r1), (r2))
+#define sbbi(imm, r) emit(SBBI, (imm), (r))
+#define sbbb(r1, r2) emit(SBBB, (r1), (r2))
+#define sbbbi(imm, r) emit(SBBBI, (imm), (r))
+
+#define mul(r1, r2) emit(MUL, (r1), (r2))
+#define muli(imm, r) emit(MULI, (imm), (r))
+#define mulb(r1, r2) emit(MULB, (r1), (r2))
+#define mulbi(imm, r) emit(MULBI, (imm), (r))
+#define mulh(r1, r2) emit(MULH, (r1), (r2))
+#define mulhs(r1, r2) emit(MULHS, (r1), (r2))
+#define div(r1, r2) emit(DIV, (r1), (r2))
+#define divi(imm, r) emit(DIVI, (imm), (r))
+#define divs(r1, r2) emit(DIVS, (r1), (r2))
+#define divsi(imm, r) emit(DIVSI, (imm), (r))
+#define mod(r1, r2) emit(MOD, (r1), (r2))
+#define modi(imm, r) emit(MODI, (imm), (r))
+#define mods(r1, r2) emit(MODS, (r1), (r2))
+#define modsi(imm, r) emit(MODSI, (imm), (r))
+
+#define not(r) emit(NOT, (r))
+#define notb(r) emit(NOTB, (r))
+#define and(r1, r2) emit(AND, (r1), (r2))
+#define andi(imm, r) emit(ANDI, (imm), (r))
+#define andb(r1, r2) emit(ANDB, (r1), (r2))
+#define andbi(imm, r) emit(ANDBI, (imm), (r))
+#define or(r1, r2) emit(OR, (r1), (r2))
+#define ori(imm, r) emit(ORI, (imm), (r))
+#define orb(r1, r2) emit(ORB, (r1), (r2))
+#define orbi(imm, r) emit(ORBI, (imm), (r))
+#define xor(r1, r2) emit(XOR, (r1), (r2))
+#define xori(imm, r) emit(XORI, (imm), (r))
+#define xorb(r1, r2) emit(XORB, (r1), (r2))
+#define xorbi(imm, r) emit(XORBI, (imm), (r))
+
+#define shl(r1, r2) emit(SHL, (r1), (r2))
+#define shli(imm, r) emit(SHLI, (imm), (r))
+#define shlb(r1, r2) emit(SHLB, (r1), (r2))
+#define shlbi(imm, r) emit(SHLBI, (imm), (r))
+#define shr(r1, r2) emit(SHR, (r1), (r2))
+#define shri(imm, r) emit(SHRI, (imm), (r))
+#define shrb(r1, r2) emit(SHRB, (r1), (r2))
+#define shrbi(imm, r) emit(SHRBI, (imm), (r))
+#define shra(r1, r2) emit(SHRA, (r1), (r2))
+#define shrai(imm, r) emit(SHRAI, (imm), (r))
+#define shrab(r1, r2) emit(SHRAB, (r1), (r2))
+#define shrabi(imm, r) emit(SHRABI, (imm), (r))
+
+#define paddb(r1, r2) emit(PADDB, (r1), (r2))
+#define pcmpeqb(r1, r2) emit(PCMPEQB, (r1), (r2))
+#define pminub(r1, r2) emit(PMINUB, (r1), (r2))
+#define pmaxub(r1, r2) emit(PMAXUB, (r1), (r2))
+#define vaddb(r1, r2) emit(VADDB, (r1), (r2))
+#define vminub(r1, r2) emit(VMINUB, (r1), (r2))
+#define vmaxub(r1, r2) emit(VMAXUB, (r1), (r2))
+#define vcmpeqb(r1, r2, r3) emit(VCMPEQB, (r1), (r2), (r3))
+#define vfindb(r1, r2, r3) emit(VFINDB, (r1), (r2), (r3))
+
+#define crc32c(r1, r2, r3, r4) emit(CRC32C, (r1), (r2), (r3), (r4))
+#define xxh32(r1, r2, r3, r4) emit(XXH32, (r1), (r2), (r3), (r4))
+
+#define cmp(r1, r2) emit(CMP, (r1), (r2))
+#define cmpi(imm, r) emit(CMPI, (imm), (r))
+#define cmpb(r1, r2) emit(CMPB, (r1), (r2))
+#define cmpbi(imm, r) emit(CMPBI, (imm), (r))
+
+#define jabs(imm) emit(JABS, (imm))
+#define je(imm) emit(JE, (imm))
+#define jne(imm) emit(JNE, (imm))
+#define jg(imm) emit(JG, (imm))
+#define jge(imm) emit(JGE, (imm))
+#define jl(imm) emit(JL, (imm))
+#define jle(imm) emit(JLE, (imm))
+#define ja(imm) emit(JA, (imm))
+#define jae(imm) emit(JAE, (imm))
+#define jb(imm) emit(JB, (imm))
+#define jbe(imm) emit(JBE, (imm))
+
+// Relative branches take the absolute target and encode its distance from
+// the end of the instruction.
+#define br(target) emit(BR, (target) - (vm->pc + instruction_size(vm, BR)))
+#define brs(target) emit(BRS, (target) - (vm->pc + instruction_size(vm, BRS)))
+#define brcc(op, target) emit((op), (target) - (vm->pc + instruction_size(vm, (op))))
+#define brccs(op, target) emit((op), (target) - (vm->pc + instruction_size(vm, (op))))
+
+#define jtab(r, table) emit(JTAB, (r), (table))
+
+#define loop(r, target) emit(LOOP, (r), (target) - (vm->pc + instruction_size(vm, LOOP)))
+#define loops(r, target) emit(LOOPS, (r), (target) - (vm->pc + instruction_size(vm, LOOPS)))
+
+#define push(r) emit(PUSH, (r))
+#define pushi(imm) emit(PUSHI, (imm))
+#define pop(r) emit(POP, (r))
+#define pushm(mask) emit(PUSHM, (mask))
+#define popm(mask) emit(POPM, (mask))
+#define call(imm) emit(CALL, (imm))
+#define callr(r) emit(CALLR, (r))
+#define bsr(target) emit(BSR, (target) - (vm->pc + instruction_size(vm, BSR)))
+#define bsrs(target) emit(BSRS, (target) - (vm->pc + instruction_size(vm, BSRS)))
+#define ret() emit(RET)
+#define enter(imm) emit(ENTER, (imm))
+#define leave() emit(LEAVE)
+
+#define bank(r) emit(BANK, (r))
+
+#define ei() emit(EI)
+#define di() emit(DI)
+#define iret() emit(IRET)
+#define wait() emit(WAIT)
+
+#define syscall(n) emit(SYSCALL, (n))
 
 #include "mov.c"
 #include "movi.c"
@@ -96,6 +231,8 @@ void reset_vm()
 #include "movbi.c"
 #include "movze.c"
 #include "movse.c"
+#include "cmov.c"
+#include "set.c"
 
 #include "st.c"
 #include "sti.c"
@@ -105,6 +242,20 @@ void reset_vm()
 #include "ldi.c"
 #include "ldb.c"
 #include "ldbi.c"
+#include "std.c"
+#include "stbd.c"
+#include "ldd.c"
+#include "ldbd.c"
+#include "stx.c"
+#include "stbx.c"
+#include "ldx.c"
+#include "ldbx.c"
+#include "bmov.c"
+#include "bfill.c"
+#include "bcmp.c"
+#include "scanb.c"
+#include "mismatch.c"
+#include "strnlen.c"
 
 #include "add.c"
 #include "addi.c"
@@ -115,6 +266,38 @@ void reset_vm()
 #include "subb.c"
 #include "subbi.c"
 
+#include "addf.c"
+#include "addfi.c"
+#include "addfb.c"
+#include "addfbi.c"
+#include "subf.c"
+#include "subfi.c"
+#include "subfb.c"
+#include "subfbi.c"
+#include "adc.c"
+#include "adci.c"
+#include "adcb.c"
+#include "adcbi.c"
+#include "sbb.c"
+#include "sbbi.c"
+#include "sbbb.c"
+#include "sbbbi.c"
+
+#include "mul.c"
+#include "muli.c"
+#include "mulb.c"
+#include "mulbi.c"
+#include "mulh.c"
+#include "mulhs.c"
+#include "div.c"
+#include "divi.c"
+#include "divs.c"
+#include "divsi.c"
+#include "mod.c"
+#include "modi.c"
+#include "mods.c"
+#include "modsi.c"
+
 #include "not.c"
 #include "notb.c"
 #include "and.c"
@@ -143,6 +326,19 @@ void reset_vm()
 #include "shrab.c"
 #include "shrabi.c"
 
+#include "paddb.c"
+#include "pcmpeqb.c"
+#include "pminub.c"
+#include "pmaxub.c"
+#include "vaddb.c"
+#include "vminub.c"
+#include "vmaxub.c"
+#include "vcmpeqb.c"
+#include "vfindb.c"
+
+#include "crc32c.c"
+#include "xxh32.c"
+
 #include "cmp.c"
 #include "cmpi.c"
 #include "cmpb.c"
@@ -160,21 +356,64 @@ void reset_vm()
 #include "jb.c"
 #include "jbe.c"
 
+#include "br.c"
+#include "brcc.c"
+#include "brs.c"
+#include "brccs.c"
+
+#include "jtab.c"
+
+#include "loop.c"
+#include "loops.c"
+
 #include "push.c"
 #include "pushi.c"
 #include "pop.c"
+#include "pushm.c"
+#include "popm.c"
 #include "call.c"
 #include "callr.c"
+#include "bsr.c"
+#include "bsrs.c"
 #include "ret.c"
+#include "enter.c"
+#include "leave.c"
+
+#include "bank.c"
+
+#include "ei.c"
+#include "di.c"
+#include "iret.c"
+#include "wait.c"
+
+#include "syscall.c"
+
+#include "verify.c"
+#include "ram.c"
+#include "bus.c"
+#include "console.c"
+#include "file.c"
+#include "timer.c"
+#include "channel.c"
+#include "fixed.c"
+#include "disassemble.c"
+#include "lib.c"
 
 int main(void)
 {
+    vm = vm_create();
+    if (vm == NULL) {
+        return 1;
+    }
+
     test_mov();
     test_movi();
     test_movb();
     test_movbi();
     test_movze();
     test_movse();
+    test_cmov();
+    test_set();
 
     test_st();
     test_sti();
@@ -184,6 +423,20 @@ int main(void)
     test_ldi();
     test_ldb();
     test_ldbi();
+    test_std();
+    test_stbd();
+    test_ldd();
+    test_ldbd();
+    test_stx();
+    test_stbx();
+    test_ldx();
+    test_ldbx();
+    test_bmov();
+    test_bfill();
+    test_bcmp();
+    test_scanb();
+    test_mismatch();
+    test_strnlen();
 
     test_add();
     test_addi();
@@ -194,6 +447,38 @@ int main(void)
     test_subb();
     test_subbi();
 
+    test_addf();
+    test_addfi();
+    test_addfb();
+    test_addfbi();
+    test_subf();
+    test_subfi();
+    test_subfb();
+    test_subfbi();
+    test_adc();
+    test_adci();
+    test_adcb();
+    test_adcbi();
+    test_sbb();
+    test_sbbi();
+    test_sbbb();
+    test_sbbbi();
+
+    test_mul();
+    test_muli();
+    test_mulb();
+    test_mulbi();
+    test_mulh();
+    test_mulhs();
+    test_div();
+    test_divi();
+    test_divs();
+    test_divsi();
+    test_mod();
+    test_modi();
+    test_mods();
+    test_modsi();
+
     test_not();
     test_notb();
     test_and();
@@ -222,6 +507,19 @@ int main(void)
     test_shrab();
     test_shrabi();
 
+    test_paddb();
+    test_pcmpeqb();
+    test_pminub();
+    test_pmaxub();
+    test_vaddb();
+    test_vminub();
+    test_vmaxub();
+    test_vcmpeqb();
+    test_vfindb();
+
+    test_crc32c();
+    test_xxh32();
+
     test_cmp();
     test_cmpi();
     test_cmpb();
@@ -239,12 +537,48 @@ int main(void)
     test_jb();
     test_jbe();
 
+    test_br();
+    test_brcc();
+    test_brs();
+    test_brccs();
+
+    test_jtab();
+
+    test_loop();
+    test_loops();
+
     test_push();
     test_pushi();
     test_pop();
+    test_pushm();
+    test_popm();
     test_call();
     test_callr();
+    test_bsr();
+    test_bsrs();
     test_ret();
+    test_enter();
+    test_leave();
+
+    test_bank();
+
+    test_ei();
+    test_di();
+    test_iret();
+    test_wait();
+
+    test_syscall();
+
+    test_verify();
+    test_ram();
+    test_bus();
+    test_console();
+    test_file();
+    test_timer();
+    test_channel();
+    test_fixed();
+    test_disassemble();
+    test_lib();
 
     return 0;
 }
@@ -0,0 +1,85 @@
+struct mismatch_test_case {
+    char *title;
+    char *a;
+    char *b;
+    uint16_t len;
+    uint16_t expect;
+    int zf;
+    int cf;
+};
+
+struct mismatch_test_case mismatch_cases[] = {
+    {
+        .title = "equal ranges",
+        .a = "hello",
+        .b = "hello",
+        .len = 5,
+        .expect = 5,
+        .zf = 1,
+        .cf = 1
+    },
+    {
+        .title = "first range is above",
+        .a = "hellp",
+        .b = "hello",
+        .len = 5,
+        .expect = 4,
+        .zf = 0,
+        .cf = 1
+    },
+    {
+        .title = "first range is below",
+        .a = "he\x01lo",
+        .b = "he\xfflo",
+        .len = 5,
+        .expect = 2,
+        .zf = 0,
+        .cf = 0
+    },
+    {
+        .title = "difference in a later stride",
+        .a = "0123456789abcdef0123456789abcdefXYZ",
+        .b = "0123456789abcdef0123456789abcdefXyZ",
+        .len = 35,
+        .expect = 33,
+        .zf = 0,
+        .cf = 0
+    },
+    {
+        .title = "difference past the length",
+        .a = "0123456789abcdef0123456789abcdefXYZ",
+        .b = "0123456789abcdef0123456789abcdefXyZ",
+        .len = 33,
+        .expect = 33,
+        .zf = 1,
+        .cf = 1
+    }
+};
+
+void test_mismatch()
+{
+    printf("test_mismatch\n");
+
+    for (int i = 0; i < arrlen(mismatch_cases); ++i) {
+        struct mismatch_test_case tcase = mismatch_cases[i];
+
+        printf("    %s\n", tcase.title);
+        reset_vm();
+
+        memcpy(vm->ram + 0x1000, tcase.a, strlen(tcase.a));
+        memcpy(vm->ram + 0x2000, tcase.b, strlen(tcase.b));
+
+        vm->regfile[R10] = 0x2000;
+        vm->regfile[R11] = 0x1000;
+        vm->regfile[R12] = tcase.len;
+        mismatch(R10, R11, R12, R13);
+        halt();
+
+        vm->pc = 0;
+        vm_start(vm);
+
+        assert(vm->regfile[R13] == tcase.expect);
+        assert(vm->flags[ZF] == tcase.zf);
+        assert(vm->flags[CF] == tcase.cf);
+    }
+}
@@ -0,0 +1,49 @@
+struct mod_test_case {
+    char *title;
+    uint16_t a;
+    uint16_t b;
+    uint16_t expect;
+};
+
+struct mod_test_case mod_cases[] = {
+    {
+        .title = "remainder",
+        .a = 7,
+        .b = 2,
+        .expect = 1
+    },
+    {
+        .title = "unsigned operands",
+        .a = 0xffff,
+        .b = 16,
+        .expect = 15
+    },
+    {
+        .title = "divisor larger than dividend",
+        .a = 3,
+        .b = 5,
+        .expect = 3
+    }
+};
+
+void test_mod()
+{
+    printf("test_mod\n");
+
+    for (int i = 0; i < arrlen(mod_cases); ++i) {
+        struct mod_test_case tcase = mod_cases[i];
+
+        printf("    %s\n", tcase.title);
+        reset_vm();
+
+        vm->regfile[R10] = tcase.a;
+        vm->regfile[R11] = tcase.b;
+        mod(R11, R10);
+        halt();
+
+        vm->pc = 0;
+        vm_start(vm);
+
+        assert(vm->regfile[R10] == tcase.expect);
+    }
+}
@@ -0,0 +1,21 @@
+
+void test_modi()
+{
+    printf("test_modi\n");
+
+    for (int i = 0; i < arrlen(mod_cases); ++i) {
+        struct mod_test_case tcase = mod_cases[i];
+
+        printf("    %s\n", tcase.title);
+        reset_vm();
+
+        vm->regfile[R10] = tcase.a;
+        modi(tcase.b, R10);
+        halt();
+
+        vm->pc = 0;
+        vm_start(vm);
+
+        assert(vm->regfile[R10] == tcase.expect);
+    }
+}
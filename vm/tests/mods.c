@@ -0,0 +1,49 @@
+struct mods_test_case {
+    char *title;
+    uint16_t a;
+    uint16_t b;
+    uint16_t expect;
+};
+
+struct mods_test_case mods_cases[] = {
+    {
+        .title = "negative dividend",
+        .a = 0xfff9,
+        .b = 2,
+        .expect = 0xffff
+    },
+    {
+        .title = "negative divisor",
+        .a = 7,
+        .b = 0xfffe,
+        .expect = 1
+    },
+    {
+        .title = "overflow",
+        .a = 0x8000,
+        .b = 0xffff,
+        .expect = 0
+    }
+};
+
+void test_mods()
+{
+    printf("test_mods\n");
+
+    for (int i = 0; i < arrlen(mods_cases); ++i) {
+        struct mods_test_case tcase = mods_cases[i];
+
+        printf("    %s\n", tcase.title);
+        reset_vm();
+
+        vm->regfile[R10] = tcase.a;
+        vm->regfile[R11] = tcase.b;
+        mods(R11, R10);
+        halt();
+
+        vm->pc = 0;
+        vm_start(vm);
+
+        assert(vm->regfile[R10] == tcase.expect);
+    }
+}
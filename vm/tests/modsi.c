@@ -0,0 +1,21 @@
+
+void test_modsi()
+{
+    printf("test_modsi\n");
+
+    for (int i = 0; i < arrlen(mods_cases); ++i) {
+        struct mods_test_case tcase = mods_cases[i];
+
+        printf("    %s\n", tcase.title);
+        reset_vm();
+
+        vm->regfile[R10] = tcase.a;
+        modsi(tcase.b, R10);
+        halt();
+
+        vm->pc = 0;
+        vm_start(vm);
+
+        assert(vm->regfile[R10] == tcase.expect);
+    }
+}
@@ -3,12 +3,12 @@ void test_mov()
     printf("test_mov\n");
     reset_vm();
 
-    regfile[R10] = 0xaabb;
+    vm->regfile[R10] = 0xaabb;
     mov(R10, R11);
     halt();
 
-    pc = 0;
-    vm_start();
+    vm->pc = 0;
+    vm_start(vm);
 
-    assert(regfile[R11] == 0xaabb);
+    assert(vm->regfile[R11] == 0xaabb);
 }
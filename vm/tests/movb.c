@@ -3,13 +3,13 @@ void test_movb()
     printf("test_movb\n");
     reset_vm();
 
-    regfile[R10] = 0xff80;
-    regfile[R11] = 0xabcd;
+    vm->regfile[R10] = 0xff80;
+    vm->regfile[R11] = 0xabcd;
     movb(R10, R11);
     halt();
 
-    pc = 0;
-    vm_start();
+    vm->pc = 0;
+    vm_start(vm);
 
-    assert(regfile[R11] == 0xab80);
+    assert(vm->regfile[R11] == 0xab80);
 }
@@ -3,13 +3,13 @@ void test_movbi()
     printf("test_movbi\n");
     reset_vm();
 
-    regfile[R10] = 0xab00;
+    vm->regfile[R10] = 0xab00;
     movbi(0x80, R10);
     halt();
 
-    pc = 0;
-    vm_start();
+    vm->pc = 0;
+    vm_start(vm);
 
-    assert(regfile[R10] == 0xab80);
+    assert(vm->regfile[R10] == 0xab80);
 }
 
@@ -6,8 +6,8 @@ void test_movi()
     movi(0xaabb, R10);
     halt();
 
-    pc = 0;
-    vm_start();
+    vm->pc = 0;
+    vm_start(vm);
 
-    assert(regfile[R10] == 0xaabb);
+    assert(vm->regfile[R10] == 0xaabb);
 }
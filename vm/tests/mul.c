@@ -0,0 +1,55 @@
+struct mul_test_case {
+    char *title;
+    uint16_t a;
+    uint16_t b;
+    uint16_t expect;
+};
+
+struct mul_test_case mul_cases[] = {
+    {
+        .title = "multiply by zero",
+        .a = 0x1234,
+        .b = 0,
+        .expect = 0
+    },
+    {
+        .title = "multiply",
+        .a = 0x0012,
+        .b = 0x0034,
+        .expect = 0x03a8
+    },
+    {
+        .title = "multiply negative",
+        .a = 0xffff,
+        .b = 2,
+        .expect = 0xfffe
+    },
+    {
+        .title = "keeps low half",
+        .a = 0x1234,
+        .b = 0x0100,
+        .expect = 0x3400
+    }
+};
+
+void test_mul()
+{
+    printf("test_mul\n");
+
+    for (int i = 0; i < arrlen(mul_cases); ++i) {
+        struct mul_test_case tcase = mul_cases[i];
+
+        printf("    %s\n", tcase.title);
+        reset_vm();
+
+        vm->regfile[R10] = tcase.a;
+        vm->regfile[R11] = tcase.b;
+        mul(R11, R10);
+        halt();
+
+        vm->pc = 0;
+        vm_start(vm);
+
+        assert(vm->regfile[R10] == tcase.expect);
+    }
+}
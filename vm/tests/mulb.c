@@ -0,0 +1,49 @@
+struct mulb_test_case {
+    char *title;
+    uint16_t a;
+    uint16_t b;
+    uint16_t expect;
+};
+
+struct mulb_test_case mulb_cases[] = {
+    {
+        .title = "multiply by zero",
+        .a = 0xab12,
+        .b = 0xcd00,
+        .expect = 0
+    },
+    {
+        .title = "ignores upper bytes",
+        .a = 0xab10,
+        .b = 0xcd10,
+        .expect = 0x0100
+    },
+    {
+        .title = "keeps high half",
+        .a = 0x00ff,
+        .b = 0x00ff,
+        .expect = 0xfe01
+    }
+};
+
+void test_mulb()
+{
+    printf("test_mulb\n");
+
+    for (int i = 0; i < arrlen(mulb_cases); ++i) {
+        struct mulb_test_case tcase = mulb_cases[i];
+
+        printf("    %s\n", tcase.title);
+        reset_vm();
+
+        vm->regfile[R10] = tcase.a;
+        vm->regfile[R11] = tcase.b;
+        mulb(R11, R10);
+        halt();
+
+        vm->pc = 0;
+        vm_start(vm);
+
+        assert(vm->regfile[R10] == tcase.expect);
+    }
+}
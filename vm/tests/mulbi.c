@@ -0,0 +1,21 @@
+
+void test_mulbi()
+{
+    printf("test_mulbi\n");
+
+    for (int i = 0; i < arrlen(mulb_cases); ++i) {
+        struct mulb_test_case tcase = mulb_cases[i];
+
+        printf("    %s\n", tcase.title);
+        reset_vm();
+
+        vm->regfile[R10] = tcase.a;
+        mulbi(tcase.b, R10);
+        halt();
+
+        vm->pc = 0;
+        vm_start(vm);
+
+        assert(vm->regfile[R10] == tcase.expect);
+    }
+}
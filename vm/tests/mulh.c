@@ -0,0 +1,49 @@
+struct mulh_test_case {
+    char *title;
+    uint16_t a;
+    uint16_t b;
+    uint16_t expect;
+};
+
+struct mulh_test_case mulh_cases[] = {
+    {
+        .title = "no high half",
+        .a = 0x0012,
+        .b = 0x0034,
+        .expect = 0
+    },
+    {
+        .title = "high half",
+        .a = 0x8000,
+        .b = 4,
+        .expect = 2
+    },
+    {
+        .title = "unsigned operands",
+        .a = 0xffff,
+        .b = 0xffff,
+        .expect = 0xfffe
+    }
+};
+
+void test_mulh()
+{
+    printf("test_mulh\n");
+
+    for (int i = 0; i < arrlen(mulh_cases); ++i) {
+        struct mulh_test_case tcase = mulh_cases[i];
+
+        printf("    %s\n", tcase.title);
+        reset_vm();
+
+        vm->regfile[R10] = tcase.a;
+        vm->regfile[R11] = tcase.b;
+        mulh(R11, R10);
+        halt();
+
+        vm->pc = 0;
+        vm_start(vm);
+
+        assert(vm->regfile[R10] == tcase.expect);
+    }
+}
@@ -0,0 +1,49 @@
+struct mulhs_test_case {
+    char *title;
+    uint16_t a;
+    uint16_t b;
+    uint16_t expect;
+};
+
+struct mulhs_test_case mulhs_cases[] = {
+    {
+        .title = "positive",
+        .a = 0x4000,
+        .b = 4,
+        .expect = 1
+    },
+    {
+        .title = "negative",
+        .a = 0xffff,
+        .b = 2,
+        .expect = 0xffff
+    },
+    {
+        .title = "both negative",
+        .a = 0xffff,
+        .b = 0xffff,
+        .expect = 0
+    }
+};
+
+void test_mulhs()
+{
+    printf("test_mulhs\n");
+
+    for (int i = 0; i < arrlen(mulhs_cases); ++i) {
+        struct mulhs_test_case tcase = mulhs_cases[i];
+
+        printf("    %s\n", tcase.title);
+        reset_vm();
+
+        vm->regfile[R10] = tcase.a;
+        vm->regfile[R11] = tcase.b;
+        mulhs(R11, R10);
+        halt();
+
+        vm->pc = 0;
+        vm_start(vm);
+
+        assert(vm->regfile[R10] == tcase.expect);
+    }
+}
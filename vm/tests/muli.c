@@ -0,0 +1,21 @@
+
+void test_muli()
+{
+    printf("test_muli\n");
+
+    for (int i = 0; i < arrlen(mul_cases); ++i) {
+        struct mul_test_case tcase = mul_cases[i];
+
+        printf("    %s\n", tcase.title);
+        reset_vm();
+
+        vm->regfile[R10] = tcase.a;
+        muli(tcase.b, R10);
+        halt();
+
+        vm->pc = 0;
+        vm_start(vm);
+
+        assert(vm->regfile[R10] == tcase.expect);
+    }
+}
@@ -3,12 +3,12 @@ void test_not()
     printf("test_not\n");
     reset_vm();
 
-    regfile[R10] = 0xff00;
+    vm->regfile[R10] = 0xff00;
     not(R10);
     halt();
 
-    pc = 0;
-    vm_start();
+    vm->pc = 0;
+    vm_start(vm);
 
-    assert(regfile[R10] == 0x00ff);
+    assert(vm->regfile[R10] == 0x00ff);
 }
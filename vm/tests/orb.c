@@ -3,13 +3,13 @@ void test_orb()
     printf("test_orb\n");
     reset_vm();
 
-    regfile[R10] = 0xabf0;
-    regfile[R11] = 0xab0f;
+    vm->regfile[R10] = 0xabf0;
+    vm->regfile[R11] = 0xab0f;
     orb(R11, R10);
     halt();
 
-    pc = 0;
-    vm_start();
+    vm->pc = 0;
+    vm_start(vm);
 
-    assert(regfile[R10] == 0xabff);
+    assert(vm->regfile[R10] == 0xabff);
 }
@@ -0,0 +1,49 @@
+struct paddb_test_case {
+    char *title;
+    uint16_t a;
+    uint16_t b;
+    uint16_t expect;
+};
+
+struct paddb_test_case paddb_cases[] = {
+    {
+        .title = "adds bytes",
+        .a = 0x1020,
+        .b = 0x0102,
+        .expect = 0x1122
+    },
+    {
+        .title = "does not carry between bytes",
+        .a = 0x01ff,
+        .b = 0x0001,
+        .expect = 0x0100
+    },
+    {
+        .title = "wraps the high byte",
+        .a = 0xff01,
+        .b = 0x0101,
+        .expect = 0x0002
+    }
+};
+
+void test_paddb()
+{
+    printf("test_paddb\n");
+
+    for (int i = 0; i < arrlen(paddb_cases); ++i) {
+        struct paddb_test_case tcase = paddb_cases[i];
+
+        printf("    %s\n", tcase.title);
+        reset_vm();
+
+        vm->regfile[R10] = tcase.a;
+        vm->regfile[R11] = tcase.b;
+        paddb(R11, R10);
+        halt();
+
+        vm->pc = 0;
+        vm_start(vm);
+
+        assert(vm->regfile[R10] == tcase.expect);
+    }
+}
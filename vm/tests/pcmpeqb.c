@@ -0,0 +1,55 @@
+struct pcmpeqb_test_case {
+    char *title;
+    uint16_t a;
+    uint16_t b;
+    uint16_t expect;
+};
+
+struct pcmpeqb_test_case pcmpeqb_cases[] = {
+    {
+        .title = "both bytes equal",
+        .a = 0xabcd,
+        .b = 0xabcd,
+        .expect = 0xffff
+    },
+    {
+        .title = "low byte equal",
+        .a = 0x12cd,
+        .b = 0xabcd,
+        .expect = 0x00ff
+    },
+    {
+        .title = "high byte equal",
+        .a = 0xab12,
+        .b = 0xabcd,
+        .expect = 0xff00
+    },
+    {
+        .title = "no byte equal",
+        .a = 0x1234,
+        .b = 0xabcd,
+        .expect = 0
+    }
+};
+
+void test_pcmpeqb()
+{
+    printf("test_pcmpeqb\n");
+
+    for (int i = 0; i < arrlen(pcmpeqb_cases); ++i) {
+        struct pcmpeqb_test_case tcase = pcmpeqb_cases[i];
+
+        printf("    %s\n", tcase.title);
+        reset_vm();
+
+        vm->regfile[R10] = tcase.a;
+        vm->regfile[R11] = tcase.b;
+        pcmpeqb(R11, R10);
+        halt();
+
+        vm->pc = 0;
+        vm_start(vm);
+
+        assert(vm->regfile[R10] == tcase.expect);
+    }
+}
@@ -0,0 +1,43 @@
+struct pmaxub_test_case {
+    char *title;
+    uint16_t a;
+    uint16_t b;
+    uint16_t expect;
+};
+
+struct pmaxub_test_case pmaxub_cases[] = {
+    {
+        .title = "takes each maximum",
+        .a = 0x10f0,
+        .b = 0x2001,
+        .expect = 0x20f0
+    },
+    {
+        .title = "unsigned bytes",
+        .a = 0x80ff,
+        .b = 0x7f00,
+        .expect = 0x80ff
+    }
+};
+
+void test_pmaxub()
+{
+    printf("test_pmaxub\n");
+
+    for (int i = 0; i < arrlen(pmaxub_cases); ++i) {
+        struct pmaxub_test_case tcase = pmaxub_cases[i];
+
+        printf("    %s\n", tcase.title);
+        reset_vm();
+
+        vm->regfile[R10] = tcase.a;
+        vm->regfile[R11] = tcase.b;
+        pmaxub(R11, R10);
+        halt();
+
+        vm->pc = 0;
+        vm_start(vm);
+
+        assert(vm->regfile[R10] == tcase.expect);
+    }
+}
@@ -0,0 +1,43 @@
+struct pminub_test_case {
+    char *title;
+    uint16_t a;
+    uint16_t b;
+    uint16_t expect;
+};
+
+struct pminub_test_case pminub_cases[] = {
+    {
+        .title = "takes each minimum",
+        .a = 0x10f0,
+        .b = 0x2001,
+        .expect = 0x1001
+    },
+    {
+        .title = "unsigned bytes",
+        .a = 0x80ff,
+        .b = 0x7f00,
+        .expect = 0x7f00
+    }
+};
+
+void test_pminub()
+{
+    printf("test_pminub\n");
+
+    for (int i = 0; i < arrlen(pminub_cases); ++i) {
+        struct pminub_test_case tcase = pminub_cases[i];
+
+        printf("    %s\n", tcase.title);
+        reset_vm();
+
+        vm->regfile[R10] = tcase.a;
+        vm->regfile[R11] = tcase.b;
+        pminub(R11, R10);
+        halt();
+
+        vm->pc = 0;
+        vm_start(vm);
+
+        assert(vm->regfile[R10] == tcase.expect);
+    }
+}
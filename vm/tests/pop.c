@@ -9,10 +9,10 @@ void test_pop()
     pop(R11);
     halt();
 
-    pc = 0;
-    vm_start();
+    vm->pc = 0;
+    vm_start(vm);
 
-    assert(regfile[RSP] == 0);
-    assert(regfile[R10] == 420);
-    assert(regfile[R11] == 69);
+    assert(vm->regfile[RSP] == 0);
+    assert(vm->regfile[R10] == 420);
+    assert(vm->regfile[R11] == 69);
 }
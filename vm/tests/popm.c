@@ -0,0 +1,55 @@
+void test_popm()
+{
+    printf("test_popm\n");
+
+    printf("    restores what pushm saved\n");
+    reset_vm();
+
+    vm->regfile[R1] = 0x1111;
+    vm->regfile[R5] = 0x5555;
+    vm->regfile[R10] = 0xaaaa;
+    vm->regfile[RSP] = 0x2000;
+
+    pushm(1 << R1 | 1 << R5 | 1 << R10);
+    movi(0, R1);
+    movi(0, R5);
+    movi(0, R10);
+    popm(1 << R1 | 1 << R5 | 1 << R10);
+    halt();
+
+    vm->pc = 0;
+    vm_start(vm);
+
+    assert(vm->regfile[RSP] == 0x2000);
+    assert(vm->regfile[R1] == 0x1111);
+    assert(vm->regfile[R5] == 0x5555);
+    assert(vm->regfile[R10] == 0xaaaa);
+
+    printf("    pops what single pushes saved\n");
+    reset_vm();
+
+    pushi(0x1111);
+    pushi(0x2222);
+    popm(1 << R3 | 1 << R4);
+    halt();
+
+    vm->pc = 0;
+    vm_start(vm);
+
+    assert(vm->regfile[R3] == 0x1111);
+    assert(vm->regfile[R4] == 0x2222);
+    assert(vm->regfile[RSP] == 0);
+
+    printf("    skips a saved stack pointer\n");
+    reset_vm();
+
+    vm->regfile[RSP] = 0x2000;
+    pushm(1 << R1 | 1 << RSP);
+    popm(1 << R1 | 1 << RSP);
+    halt();
+
+    vm->pc = 0;
+    vm_start(vm);
+
+    assert(vm->regfile[RSP] == 0x2000);
+}
@@ -9,10 +9,10 @@ void test_push()
     push(R10);
     halt();
 
-    pc = 0;
-    vm_start();
+    vm->pc = 0;
+    vm_start(vm);
 
-    assert(regfile[RSP] == RAM_CAP - (2 * 2));
-    assert(read_word(RAM_CAP - (2 * 1)) == 69);
-    assert(read_word(RAM_CAP - (2 * 2)) == 420);
+    assert(vm->regfile[RSP] == RAM_CAP - (2 * 2));
+    assert(read_word(vm, RAM_CAP - (2 * 1)) == 69);
+    assert(read_word(vm, RAM_CAP - (2 * 2)) == 420);
 }
@@ -7,10 +7,10 @@ void test_pushi()
     pushi(420);
     halt();
 
-    pc = 0;
-    vm_start();
+    vm->pc = 0;
+    vm_start(vm);
 
-    assert(regfile[RSP] == RAM_CAP - (2 * 2));
-    assert(read_word(RAM_CAP - (2 * 1)) == 69);
-    assert(read_word(RAM_CAP - (2 * 2)) == 420);
+    assert(vm->regfile[RSP] == RAM_CAP - (2 * 2));
+    assert(read_word(vm, RAM_CAP - (2 * 1)) == 69);
+    assert(read_word(vm, RAM_CAP - (2 * 2)) == 420);
 }
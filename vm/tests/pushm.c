@@ -0,0 +1,53 @@
+void test_pushm()
+{
+    printf("test_pushm\n");
+
+    printf("    same layout as single pushes\n");
+    reset_vm();
+
+    vm->regfile[R1] = 0x1111;
+    vm->regfile[R5] = 0x5555;
+    vm->regfile[R10] = 0xaaaa;
+    vm->regfile[RSP] = 0x2000;
+
+    pushm(1 << R1 | 1 << R5 | 1 << R10);
+    halt();
+
+    vm->pc = 0;
+    vm_start(vm);
+
+    assert(vm->regfile[RSP] == 0x2000 - 6);
+    assert(read_word(vm, 0x2000 - 2) == 0x1111);
+    assert(read_word(vm, 0x2000 - 4) == 0x5555);
+    assert(read_word(vm, 0x2000 - 6) == 0xaaaa);
+
+    printf("    empty mask\n");
+    reset_vm();
+
+    vm->regfile[RSP] = 0x2000;
+    pushm(0);
+    halt();
+
+    vm->pc = 0;
+    vm_start(vm);
+
+    assert(vm->regfile[RSP] == 0x2000);
+
+    printf("    wraps around the end of ram\n");
+    reset_vm();
+
+    vm->regfile[R1] = 0x1111;
+    vm->regfile[R2] = 0x2222;
+
+    vm->pc = 0x100;
+    pushm(1 << R1 | 1 << R2);
+    halt();
+
+    vm->pc = 0x100;
+    vm->regfile[RSP] = 2;
+    vm_start(vm);
+
+    assert(vm->regfile[RSP] == 0xfffe);
+    assert(read_word(vm, 0) == 0x1111);
+    assert(read_word(vm, 0xfffe) == 0x2222);
+}
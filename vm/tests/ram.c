@@ -0,0 +1,83 @@
+int resident(uint8_t *p, int len)
+{
+    long page;
+    unsigned char vec[RAM_CAP];
+    int n;
+
+    page = sysconf(_SC_PAGESIZE);
+    assert(mincore(p, len, vec) == 0);
+
+    n = 0;
+    for (int i = 0; i < len / page; ++i) {
+        n += vec[i] & 1;
+    }
+
+    return n;
+}
+
+int ram_resident(void)
+{
+    return resident(vm->ram, RAM_CAP);
+}
+
+void test_ram()
+{
+    long page;
+    struct vm *m;
+
+    printf("test_ram\n");
+
+    printf("    words wrap around past the end\n");
+    reset_vm();
+
+    write_word(vm, 0xabcd, 0xffff);
+    assert(vm->ram[0xffff] == 0xcd);
+    assert(vm->ram[0] == 0xab);
+    assert(read_word(vm, 0xffff) == 0xabcd);
+
+    page = sysconf(_SC_PAGESIZE);
+
+    if (page >= RAM_CAP) {
+        printf("    skipped, host pages are too large\n");
+        return;
+    }
+
+    printf("    only stores allocate pages\n");
+    reset_vm();
+
+    assert(ram_resident() == 0);
+
+    vm->regfile[R10] = 0xabcd;
+    vm->regfile[R11] = 0x5000;
+
+    st(R10, R11);
+    halt();
+
+    vm->pc = 0;
+    vm_start(vm);
+
+    assert(ram_resident() == 2);
+    assert(read_word(vm, 0x5000) == 0xabcd);
+
+    printf("    clearing releases pages\n");
+    reset_vm();
+
+    assert(ram_resident() == 0);
+    assert(read_word(vm, 0x5000) == 0);
+
+    printf("    code map holds only the pages of the image\n");
+    m = vm_create();
+    assert(m != NULL);
+    assert(resident(m->code_map, RAM_CAP) == 0);
+
+    assert(vm_load(m, 0x3000, (uint8_t[]) {HALT}, 1, ENCODING_VARIABLE) == 0);
+    assert(m->verified);
+    assert(resident(m->code_map, RAM_CAP) == 1);
+
+    assert(vm_load(m, 0x5000, (uint8_t[]) {HALT}, 1, ENCODING_VARIABLE) == 0);
+    assert(m->verified);
+    assert(resident(m->code_map, RAM_CAP) == 1);
+    assert(m->code_map[0x3000] == CODE_NONE);
+
+    vm_destroy(m);
+}
@@ -7,12 +7,12 @@ void test_ret()
     movi(2, R10);
     halt();
 
-    pc = 69;
+    vm->pc = 69;
     movi(1, R10);
     ret();
 
-    pc = 0;
-    vm_start();
+    vm->pc = 0;
+    vm_start(vm);
 
-    assert(regfile[R10] == 2);
+    assert(vm->regfile[R10] == 2);
 }
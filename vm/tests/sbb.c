@@ -0,0 +1,96 @@
+struct sbb_test_case {
+    char *title;
+    uint16_t a;
+    uint16_t b;
+    int carry;
+    uint16_t expect;
+    int cf;
+    int of;
+    int zf;
+};
+
+struct sbb_test_case sbb_cases[] = {
+    {
+        .title = "without borrow",
+        .a = 5,
+        .b = 2,
+        .carry = 1,
+        .expect = 3,
+        .cf = 1,
+        .of = 0,
+        .zf = 0
+    },
+    {
+        .title = "with borrow",
+        .a = 5,
+        .b = 2,
+        .carry = 0,
+        .expect = 2,
+        .cf = 1,
+        .of = 0,
+        .zf = 0
+    },
+    {
+        .title = "borrow in borrows out",
+        .a = 0,
+        .b = 0,
+        .carry = 0,
+        .expect = 0xffff,
+        .cf = 0,
+        .of = 0,
+        .zf = 0
+    },
+    {
+        .title = "borrow in reaches zero",
+        .a = 1,
+        .b = 0,
+        .carry = 0,
+        .expect = 0,
+        .cf = 1,
+        .of = 0,
+        .zf = 1
+    }
+};
+
+void test_sbb()
+{
+    printf("test_sbb\n");
+
+    for (int i = 0; i < arrlen(sbb_cases); ++i) {
+        struct sbb_test_case tcase = sbb_cases[i];
+
+        printf("    %s\n", tcase.title);
+        reset_vm();
+
+        vm->flags[CF] = tcase.carry;
+        vm->regfile[R10] = tcase.a;
+        vm->regfile[R11] = tcase.b;
+        sbb(R11, R10);
+        halt();
+
+        vm->pc = 0;
+        vm_start(vm);
+
+        assert(vm->regfile[R10] == tcase.expect);
+        assert(vm->flags[CF] == tcase.cf);
+        assert(vm->flags[OF] == tcase.of);
+        assert(vm->flags[ZF] == tcase.zf);
+    }
+
+    printf("    chains a 32-bit subtraction\n");
+    reset_vm();
+
+    vm->regfile[R0] = 0x0000;
+    vm->regfile[R1] = 0x0002;
+    vm->regfile[R2] = 0x0001;
+    vm->regfile[R3] = 0x0000;
+    subf(R2, R0);
+    sbb(R3, R1);
+    halt();
+
+    vm->pc = 0;
+    vm_start(vm);
+
+    assert(vm->regfile[R0] == 0xffff);
+    assert(vm->regfile[R1] == 0x0001);
+}
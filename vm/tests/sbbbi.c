@@ -0,0 +1,25 @@
+
+void test_sbbbi()
+{
+    printf("test_sbbbi\n");
+
+    for (int i = 0; i < arrlen(sbbb_cases); ++i) {
+        struct sbbb_test_case tcase = sbbb_cases[i];
+
+        printf("    %s\n", tcase.title);
+        reset_vm();
+
+        vm->flags[CF] = tcase.carry;
+        vm->regfile[R10] = tcase.a;
+        sbbbi(tcase.b, R10);
+        halt();
+
+        vm->pc = 0;
+        vm_start(vm);
+
+        assert(vm->regfile[R10] == tcase.expect);
+        assert(vm->flags[CF] == tcase.cf);
+        assert(vm->flags[OF] == tcase.of);
+        assert(vm->flags[ZF] == tcase.zf);
+    }
+}
@@ -0,0 +1,89 @@
+struct scanb_test_case {
+    char *title;
+    char *data;
+    uint8_t val;
+    uint16_t len;
+    uint16_t expect;
+    int zf;
+};
+
+struct scanb_test_case scanb_cases[] = {
+    {
+        .title = "finds the first match",
+        .data = "key=value;x=y;zz",
+        .val = ';',
+        .len = 16,
+        .expect = 9,
+        .zf = 1
+    },
+    {
+        .title = "match past the length is a miss",
+        .data = "key=value;x=y;zz",
+        .val = ';',
+        .len = 9,
+        .expect = 9,
+        .zf = 0
+    },
+    {
+        .title = "finds a match in a long range",
+        .data = "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaab",
+        .val = 'b',
+        .len = 50,
+        .expect = 49,
+        .zf = 1
+    },
+    {
+        .title = "empty range",
+        .data = ";",
+        .val = ';',
+        .len = 0,
+        .expect = 0,
+        .zf = 0
+    }
+};
+
+void test_scanb()
+{
+    printf("test_scanb\n");
+
+    for (int i = 0; i < arrlen(scanb_cases); ++i) {
+        struct scanb_test_case tcase = scanb_cases[i];
+
+        printf("    %s\n", tcase.title);
+        reset_vm();
+
+        memcpy(vm->ram + 0x1000, tcase.data, strlen(tcase.data));
+
+        vm->regfile[R10] = tcase.val;
+        vm->regfile[R11] = 0x1000;
+        vm->regfile[R12] = tcase.len;
+        scanb(R10, R11, R12, R13);
+        halt();
+
+        vm->pc = 0;
+        vm_start(vm);
+
+        assert(vm->regfile[R13] == tcase.expect);
+        assert(vm->flags[ZF] == tcase.zf);
+    }
+
+    printf("    wraps around the end of ram\n");
+    reset_vm();
+
+    for (int i = 0; i < 8; ++i) {
+        write_byte(vm, i == 6 ? ';' : 'x', 0xfffc + i);
+    }
+
+    vm->pc = 0x100;
+    vm->regfile[R10] = ';';
+    vm->regfile[R11] = 0xfffc;
+    vm->regfile[R12] = 8;
+    scanb(R10, R11, R12, R13);
+    halt();
+
+    vm->pc = 0x100;
+    vm_start(vm);
+
+    assert(vm->regfile[R13] == 6);
+    assert(vm->flags[ZF] == 1);
+}
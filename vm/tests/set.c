@@ -0,0 +1,73 @@
+struct set_test_case {
+    char *title;
+    enum vm_condition cond;
+    uint16_t a;
+    uint16_t b;
+    uint16_t expect;
+};
+
+struct set_test_case set_cases[] = {
+    { .title = "e holds", .cond = COND_E, .a = 5, .b = 5, .expect = 1 },
+    { .title = "e fails", .cond = COND_E, .a = 5, .b = 4, .expect = 0 },
+    { .title = "ne holds", .cond = COND_NE, .a = 5, .b = 4, .expect = 1 },
+    { .title = "ne fails", .cond = COND_NE, .a = 5, .b = 5, .expect = 0 },
+    { .title = "g holds", .cond = COND_G, .a = 5, .b = 0xfffb, .expect = 1 },
+    { .title = "g fails", .cond = COND_G, .a = 5, .b = 5, .expect = 0 },
+    { .title = "ge holds", .cond = COND_GE, .a = 5, .b = 5, .expect = 1 },
+    { .title = "ge fails", .cond = COND_GE, .a = 0xfffb, .b = 5, .expect = 0 },
+    { .title = "l holds", .cond = COND_L, .a = 0xfffb, .b = 5, .expect = 1 },
+    { .title = "l fails", .cond = COND_L, .a = 5, .b = 5, .expect = 0 },
+    { .title = "le holds", .cond = COND_LE, .a = 5, .b = 5, .expect = 1 },
+    { .title = "le fails", .cond = COND_LE, .a = 5, .b = 0xfffb, .expect = 0 },
+    { .title = "a holds", .cond = COND_A, .a = 0xfffb, .b = 5, .expect = 1 },
+    { .title = "a fails", .cond = COND_A, .a = 5, .b = 5, .expect = 0 },
+    { .title = "ae holds", .cond = COND_AE, .a = 5, .b = 5, .expect = 1 },
+    { .title = "ae fails", .cond = COND_AE, .a = 4, .b = 5, .expect = 0 },
+    { .title = "b holds", .cond = COND_B, .a = 4, .b = 5, .expect = 1 },
+    { .title = "b fails", .cond = COND_B, .a = 5, .b = 5, .expect = 0 },
+    { .title = "be holds", .cond = COND_BE, .a = 5, .b = 5, .expect = 1 },
+    { .title = "be fails", .cond = COND_BE, .a = 0xfffb, .b = 5, .expect = 0 }
+};
+
+void test_set()
+{
+    printf("test_set\n");
+
+    for (int i = 0; i < arrlen(set_cases); ++i) {
+        struct set_test_case tcase = set_cases[i];
+
+        printf("    %s\n", tcase.title);
+        reset_vm();
+
+        vm->regfile[R10] = tcase.a;
+        vm->regfile[R11] = 0xabcd;
+        cmpi(tcase.b, R10);
+        set(tcase.cond, R11);
+        halt();
+
+        vm->pc = 0;
+        vm_start(vm);
+
+        assert(vm->regfile[R11] == tcase.expect);
+    }
+
+    printf("    rejects invalid condition\n");
+    reset_vm();
+
+    set(VM_CONDITION_COUNT, R11);
+    halt();
+
+    assert(verify_image(vm, 0) == -1);
+
+    printf("    faults on invalid condition\n");
+    reset_vm();
+
+    vm->regfile[R11] = 0xabcd;
+    set(VM_CONDITION_COUNT, R11);
+    halt();
+
+    vm->pc = 0;
+    vm_start(vm);
+
+    assert(vm->regfile[R11] == 0xabcd);
+}
@@ -3,13 +3,13 @@ void test_shl()
     printf("test_shl\n");
     reset_vm();
 
-    regfile[R10] = 0xffff;
-    regfile[R11] = 4;
+    vm->regfile[R10] = 0xffff;
+    vm->regfile[R11] = 4;
     shl(R11, R10);
     halt();
 
-    pc = 0;
-    vm_start();
+    vm->pc = 0;
+    vm_start(vm);
 
-    assert(regfile[R10] == 0xfff0);
+    assert(vm->regfile[R10] == 0xfff0);
 }
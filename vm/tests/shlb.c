@@ -3,13 +3,13 @@ void test_shlb()
     printf("test_shlb\n");
     reset_vm();
 
-    regfile[R10] = 0xabff;
-    regfile[R11] = 4;
+    vm->regfile[R10] = 0xabff;
+    vm->regfile[R11] = 4;
     shlb(R11, R10);
     halt();
 
-    pc = 0;
-    vm_start();
+    vm->pc = 0;
+    vm_start(vm);
 
-    assert(regfile[R10] == 0xabf0);
+    assert(vm->regfile[R10] == 0xabf0);
 }
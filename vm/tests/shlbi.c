@@ -3,12 +3,12 @@ void test_shlbi()
     printf("test_shlbi\n");
     reset_vm();
 
-    regfile[R10] = 0xabff;
+    vm->regfile[R10] = 0xabff;
     shlbi(4, R10);
     halt();
 
-    pc = 0;
-    vm_start();
+    vm->pc = 0;
+    vm_start(vm);
 
-    assert(regfile[R10] == 0xabf0);
+    assert(vm->regfile[R10] == 0xabf0);
 }
@@ -5,26 +5,26 @@ void test_shr()
     printf("    sign bit is set\n");
     reset_vm();
 
-    regfile[R10] = 0x8000;
-    regfile[R11] = 4;
+    vm->regfile[R10] = 0x8000;
+    vm->regfile[R11] = 4;
     shr(R11, R10);
     halt();
 
-    pc = 0;
-    vm_start();
+    vm->pc = 0;
+    vm_start(vm);
 
-    assert(regfile[R10] == 0x0800);
+    assert(vm->regfile[R10] == 0x0800);
 
     printf("    sign bit is not set\n");
     reset_vm();
 
-    regfile[R10] = 0x7fff;
-    regfile[R11] = 4;
+    vm->regfile[R10] = 0x7fff;
+    vm->regfile[R11] = 4;
     shr(R11, R10);
     halt();
 
-    pc = 0;
-    vm_start();
+    vm->pc = 0;
+    vm_start(vm);
 
-    assert(regfile[R10] == 0x07ff);
+    assert(vm->regfile[R10] == 0x07ff);
 }
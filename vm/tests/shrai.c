@@ -5,24 +5,24 @@ void test_shrai()
     printf("    sign bit is set\n");
     reset_vm();
 
-    regfile[R10] = 0x8000;
+    vm->regfile[R10] = 0x8000;
     shrai(4, R10);
     halt();
 
-    pc = 0;
-    vm_start();
+    vm->pc = 0;
+    vm_start(vm);
 
-    assert(regfile[R10] == 0xf800);
+    assert(vm->regfile[R10] == 0xf800);
 
     printf("    sign bit is not set\n");
     reset_vm();
 
-    regfile[R10] = 0x7fff;
+    vm->regfile[R10] = 0x7fff;
     shrai(4, R10);
     halt();
 
-    pc = 0;
-    vm_start();
+    vm->pc = 0;
+    vm_start(vm);
 
-    assert(regfile[R10] == 0x07ff);
+    assert(vm->regfile[R10] == 0x07ff);
 }
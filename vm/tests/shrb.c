@@ -5,26 +5,26 @@ void test_shrb()
     printf("    sign bit is set\n");
     reset_vm();
 
-    regfile[R10] = 0xab80;
-    regfile[R11] = 4;
+    vm->regfile[R10] = 0xab80;
+    vm->regfile[R11] = 4;
     shrb(R11, R10);
     halt();
 
-    pc = 0;
-    vm_start();
+    vm->pc = 0;
+    vm_start(vm);
 
-    assert(regfile[R10] == 0xab08);
+    assert(vm->regfile[R10] == 0xab08);
 
     printf("    sign bit is not set\n");
     reset_vm();
 
-    regfile[R10] = 0xab7f;
-    regfile[R11] = 4;
+    vm->regfile[R10] = 0xab7f;
+    vm->regfile[R11] = 4;
     shrb(R11, R10);
     halt();
 
-    pc = 0;
-    vm_start();
+    vm->pc = 0;
+    vm_start(vm);
 
-    assert(regfile[R10] == 0xab07);
+    assert(vm->regfile[R10] == 0xab07);
 }
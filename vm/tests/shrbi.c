@@ -5,24 +5,24 @@ void test_shrbi()
     printf("    sign bit is set\n");
     reset_vm();
 
-    regfile[R10] = 0xab80;
+    vm->regfile[R10] = 0xab80;
     shrbi(4, R10);
     halt();
 
-    pc = 0;
-    vm_start();
+    vm->pc = 0;
+    vm_start(vm);
 
-    assert(regfile[R10] == 0xab08);
+    assert(vm->regfile[R10] == 0xab08);
 
     printf("    sign bit is not set\n");
     reset_vm();
 
-    regfile[R10] = 0xab7f;
+    vm->regfile[R10] = 0xab7f;
     shrbi(4, R10);
     halt();
 
-    pc = 0;
-    vm_start();
+    vm->pc = 0;
+    vm_start(vm);
 
-    assert(regfile[R10] == 0xab07);
+    assert(vm->regfile[R10] == 0xab07);
 }
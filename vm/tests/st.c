@@ -3,14 +3,30 @@ void test_st()
     printf("test_st\n");
     reset_vm();
 
-    regfile[R10] = 0xabcd;
-    regfile[R11] = 100;
+    vm->regfile[R10] = 0xabcd;
+    vm->regfile[R11] = 100;
 
     st(R10, R11);
     halt();
 
-    pc = 0;
-    vm_start();
+    vm->pc = 0;
+    vm_start(vm);
 
-    assert(read_word(regfile[R11]) == regfile[R10]);
+    assert(read_word(vm, vm->regfile[R11]) == vm->regfile[R10]);
+
+    printf("    wraps around the end of ram\n");
+    reset_vm();
+
+    vm->regfile[R10] = 0xabcd;
+    vm->regfile[R11] = 0xffff;
+
+    vm->pc = 0x100;
+    st(R10, R11);
+    halt();
+
+    vm->pc = 0x100;
+    vm_start(vm);
+
+    assert(read_byte(vm, 0xffff) == 0xcd);
+    assert(read_byte(vm, 0) == 0xab);
 }
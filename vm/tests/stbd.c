@@ -0,0 +1,17 @@
+void test_stbd()
+{
+    printf("test_stbd\n");
+    reset_vm();
+
+    vm->regfile[R10] = 0xabcd;
+    vm->regfile[RBP] = 0x2000;
+
+    stbd(R10, RBP, -1);
+    halt();
+
+    vm->pc = 0;
+    vm_start(vm);
+
+    assert(read_byte(vm, 0x1fff) == 0xcd);
+    assert(read_byte(vm, 0x2000) == 0);
+}
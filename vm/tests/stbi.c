@@ -3,14 +3,14 @@ void test_stbi()
     printf("test_stbi\n");
     reset_vm();
 
-    regfile[R10] = 0xabcd;
+    vm->regfile[R10] = 0xabcd;
 
     stbi(R10, 100);
     halt();
 
-    pc = 0;
-    vm_start();
+    vm->pc = 0;
+    vm_start(vm);
 
-    assert(read_byte(100) == 0xcd);
+    assert(read_byte(vm, 100) == 0xcd);
 }
 
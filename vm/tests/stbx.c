@@ -0,0 +1,18 @@
+void test_stbx()
+{
+    printf("test_stbx\n");
+    reset_vm();
+
+    vm->regfile[R10] = 0x1000;
+    vm->regfile[R11] = 5;
+    vm->regfile[R12] = 0xabcd;
+
+    stbx(R10, R11, 1, R12);
+    halt();
+
+    vm->pc = 0;
+    vm_start(vm);
+
+    assert(read_byte(vm, 0x1005) == 0xcd);
+    assert(read_byte(vm, 0x1006) == 0);
+}
@@ -0,0 +1,33 @@
+void test_std()
+{
+    printf("test_std\n");
+
+    printf("    positive displacement\n");
+    reset_vm();
+
+    vm->regfile[R10] = 0xabcd;
+    vm->regfile[R11] = 0x1000;
+
+    std(R10, R11, 6);
+    halt();
+
+    vm->pc = 0;
+    vm_start(vm);
+
+    assert(read_word(vm, 0x1006) == 0xabcd);
+    assert(vm->regfile[R11] == 0x1000);
+
+    printf("    negative displacement from the frame pointer\n");
+    reset_vm();
+
+    vm->regfile[R10] = 0x1234;
+    vm->regfile[RBP] = 0x2000;
+
+    std(R10, RBP, -4);
+    halt();
+
+    vm->pc = 0;
+    vm_start(vm);
+
+    assert(read_word(vm, 0x1ffc) == 0x1234);
+}
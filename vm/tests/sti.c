@@ -3,13 +3,13 @@ void test_sti()
     printf("test_sti\n");
     reset_vm();
 
-    regfile[R10] = 0xabcd;
+    vm->regfile[R10] = 0xabcd;
 
     sti(R10, 100);
     halt();
 
-    pc = 0;
-    vm_start();
+    vm->pc = 0;
+    vm_start(vm);
 
-    assert(read_word(100) == regfile[R10]);
+    assert(read_word(vm, 100) == vm->regfile[R10]);
 }
@@ -0,0 +1,57 @@
+struct strnlen_test_case {
+    char *title;
+    char *data;
+    uint16_t limit;
+    uint16_t expect;
+    int zf;
+};
+
+struct strnlen_test_case strnlen_cases[] = {
+    {
+        .title = "terminated string",
+        .data = "hello",
+        .limit = 100,
+        .expect = 5,
+        .zf = 1
+    },
+    {
+        .title = "empty string",
+        .data = "",
+        .limit = 100,
+        .expect = 0,
+        .zf = 1
+    },
+    {
+        .title = "stops at the limit",
+        .data = "hello",
+        .limit = 3,
+        .expect = 3,
+        .zf = 0
+    }
+};
+
+void test_strnlen()
+{
+    printf("test_strnlen\n");
+
+    for (int i = 0; i < arrlen(strnlen_cases); ++i) {
+        struct strnlen_test_case tcase = strnlen_cases[i];
+
+        printf("    %s\n", tcase.title);
+        reset_vm();
+
+        memset(vm->ram + 0x1000, 'x', 200);
+        memcpy(vm->ram + 0x1000, tcase.data, strlen(tcase.data) + 1);
+
+        vm->regfile[R10] = 0x1000;
+        vm->regfile[R11] = tcase.limit;
+        strnlen(R10, R11, R12);
+        halt();
+
+        vm->pc = 0;
+        vm_start(vm);
+
+        assert(vm->regfile[R12] == tcase.expect);
+        assert(vm->flags[ZF] == tcase.zf);
+    }
+}
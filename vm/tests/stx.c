@@ -0,0 +1,18 @@
+void test_stx()
+{
+    printf("test_stx\n");
+    reset_vm();
+
+    vm->regfile[R10] = 0x1000;
+    vm->regfile[R11] = 3;
+    vm->regfile[R12] = 0xabcd;
+
+    stx(R10, R11, 2, R12);
+    halt();
+
+    vm->pc = 0;
+    vm_start(vm);
+
+    assert(read_word(vm, 0x1006) == 0xabcd);
+    assert(vm->regfile[R11] == 3);
+}
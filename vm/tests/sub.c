@@ -36,14 +36,14 @@ void test_sub()
         printf("    %s\n", tcase.title);
         reset_vm();
 
-        regfile[R10] = tcase.a;
-        regfile[R11] = tcase.b;
+        vm->regfile[R10] = tcase.a;
+        vm->regfile[R11] = tcase.b;
         sub(R11, R10);
         halt();
 
-        pc = 0;
-        vm_start();
+        vm->pc = 0;
+        vm_start(vm);
 
-        assert(regfile[R10] == tcase.expect);
+        assert(vm->regfile[R10] == tcase.expect);
     }
 }
@@ -0,0 +1,89 @@
+struct subf_test_case {
+    char *title;
+    uint16_t a;
+    uint16_t b;
+    int carry;
+    uint16_t expect;
+    int cf;
+    int of;
+    int zf;
+};
+
+struct subf_test_case subf_cases[] = {
+    {
+        .title = "subtract",
+        .a = 3,
+        .b = 1,
+        .carry = 0,
+        .expect = 2,
+        .cf = 1,
+        .of = 0,
+        .zf = 0
+    },
+    {
+        .title = "subtract zero",
+        .a = 5,
+        .b = 0,
+        .carry = 0,
+        .expect = 5,
+        .cf = 1,
+        .of = 0,
+        .zf = 0
+    },
+    {
+        .title = "borrow",
+        .a = 1,
+        .b = 2,
+        .carry = 1,
+        .expect = 0xffff,
+        .cf = 0,
+        .of = 0,
+        .zf = 0
+    },
+    {
+        .title = "equal",
+        .a = 7,
+        .b = 7,
+        .carry = 0,
+        .expect = 0,
+        .cf = 1,
+        .of = 0,
+        .zf = 1
+    },
+    {
+        .title = "signed overflow",
+        .a = 0x8000,
+        .b = 1,
+        .carry = 0,
+        .expect = 0x7fff,
+        .cf = 1,
+        .of = 1,
+        .zf = 0
+    }
+};
+
+void test_subf()
+{
+    printf("test_subf\n");
+
+    for (int i = 0; i < arrlen(subf_cases); ++i) {
+        struct subf_test_case tcase = subf_cases[i];
+
+        printf("    %s\n", tcase.title);
+        reset_vm();
+
+        vm->flags[CF] = tcase.carry;
+        vm->regfile[R10] = tcase.a;
+        vm->regfile[R11] = tcase.b;
+        subf(R11, R10);
+        halt();
+
+        vm->pc = 0;
+        vm_start(vm);
+
+        assert(vm->regfile[R10] == tcase.expect);
+        assert(vm->flags[CF] == tcase.cf);
+        assert(vm->flags[OF] == tcase.of);
+        assert(vm->flags[ZF] == tcase.zf);
+    }
+}
@@ -0,0 +1,79 @@
+struct subfb_test_case {
+    char *title;
+    uint16_t a;
+    uint16_t b;
+    int carry;
+    uint16_t expect;
+    int cf;
+    int of;
+    int zf;
+};
+
+struct subfb_test_case subfb_cases[] = {
+    {
+        .title = "subtract",
+        .a = 0xab03,
+        .b = 0x01,
+        .carry = 0,
+        .expect = 0xab02,
+        .cf = 1,
+        .of = 0,
+        .zf = 0
+    },
+    {
+        .title = "borrow",
+        .a = 0xab01,
+        .b = 0x02,
+        .carry = 1,
+        .expect = 0xabff,
+        .cf = 0,
+        .of = 0,
+        .zf = 0
+    },
+    {
+        .title = "equal",
+        .a = 0xab07,
+        .b = 0x07,
+        .carry = 0,
+        .expect = 0xab00,
+        .cf = 1,
+        .of = 0,
+        .zf = 1
+    },
+    {
+        .title = "signed overflow",
+        .a = 0xab80,
+        .b = 0x01,
+        .carry = 0,
+        .expect = 0xab7f,
+        .cf = 1,
+        .of = 1,
+        .zf = 0
+    }
+};
+
+void test_subfb()
+{
+    printf("test_subfb\n");
+
+    for (int i = 0; i < arrlen(subfb_cases); ++i) {
+        struct subfb_test_case tcase = subfb_cases[i];
+
+        printf("    %s\n", tcase.title);
+        reset_vm();
+
+        vm->flags[CF] = tcase.carry;
+        vm->regfile[R10] = tcase.a;
+        vm->regfile[R11] = tcase.b;
+        subfb(R11, R10);
+        halt();
+
+        vm->pc = 0;
+        vm_start(vm);
+
+        assert(vm->regfile[R10] == tcase.expect);
+        assert(vm->flags[CF] == tcase.cf);
+        assert(vm->flags[OF] == tcase.of);
+        assert(vm->flags[ZF] == tcase.zf);
+    }
+}
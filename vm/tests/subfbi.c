@@ -0,0 +1,25 @@
+
+void test_subfbi()
+{
+    printf("test_subfbi\n");
+
+    for (int i = 0; i < arrlen(subfb_cases); ++i) {
+        struct subfb_test_case tcase = subfb_cases[i];
+
+        printf("    %s\n", tcase.title);
+        reset_vm();
+
+        vm->flags[CF] = tcase.carry;
+        vm->regfile[R10] = tcase.a;
+        subfbi(tcase.b, R10);
+        halt();
+
+        vm->pc = 0;
+        vm_start(vm);
+
+        assert(vm->regfile[R10] == tcase.expect);
+        assert(vm->flags[CF] == tcase.cf);
+        assert(vm->flags[OF] == tcase.of);
+        assert(vm->flags[ZF] == tcase.zf);
+    }
+}
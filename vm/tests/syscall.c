@@ -0,0 +1,36 @@
+void test_syscall()
+{
+    printf("test_syscall\n");
+
+    printf("    stops after the call\n");
+    reset_vm();
+
+    movi(1, R10);
+    syscall(7);
+    movi(2, R10);
+    halt();
+
+    vm->pc = 0;
+    vm_start(vm);
+
+    assert(vm->regfile[R10] == 1);
+    assert(vm->syscall_number == 7);
+    assert(vm->exit_pc == 4);
+    assert(vm->pc == 6);
+
+    printf("    stops verified code too\n");
+    reset_vm();
+
+    syscall(0xff);
+    movi(2, R10);
+    halt();
+
+    assert(verify_image(vm, 0) == 0);
+
+    vm->pc = 0;
+    vm_start(vm);
+
+    assert(vm->regfile[R10] == 0);
+    assert(vm->syscall_number == 0xff);
+    assert(vm->pc == 2);
+}
@@ -0,0 +1,168 @@
+// Counts into R12 and returns.
+void write_timer_handler()
+{
+    write_word(vm, 0x100, INTERRUPT_VECTORS + 2 * INTERRUPT_TIMER);
+
+    vm->pc = 0x100;
+    addi(1, R12);
+    iret();
+}
+
+// Adds to R11 100 times, the flags of CMPI have to survive interrupts.
+void write_timer_loop(int period)
+{
+    int loop;
+
+    ei();
+    movi(period, R10);
+    sti(R10, TIMER_RELOAD);
+    loop = vm->pc;
+    addi(1, R11);
+    cmpi(100, R11);
+    jne(loop);
+    movi(0, R10);
+    sti(R10, TIMER_RELOAD);
+    halt();
+}
+
+void test_timer()
+{
+    struct timer t;
+    int loop;
+
+    printf("test_timer\n");
+
+    printf("    interrupts after reload instructions\n");
+    reset_vm();
+    assert(timer_attach(vm, &t) == 0);
+
+    ei();
+    movi(5, R10);
+    sti(R10, TIMER_RELOAD);
+    loop = vm->pc;
+    addi(1, R11);
+    jabs(loop);
+
+    write_word(vm, 0x100, INTERRUPT_VECTORS + 2 * INTERRUPT_TIMER);
+    vm->pc = 0x100;
+    movi(1, R12);
+    halt();
+
+    vm->pc = 0;
+    vm_start(vm);
+
+    assert(vm->regfile[R11] == 3);
+    assert(vm->regfile[R12] == 1);
+    assert(vm->regfile[RSP] == RAM_CAP - 4);
+    assert(read_word(vm, RAM_CAP - 2) == loop + instruction_size(vm, ADDI));
+    assert(read_word(vm, RAM_CAP - 4) == 1 << IF);
+    assert(vm->flags[IF] == 0);
+
+    printf("    holds the interrupt until enabled\n");
+    reset_vm();
+    assert(timer_attach(vm, &t) == 0);
+
+    movi(3, R10);
+    sti(R10, TIMER_RELOAD);
+    for (int i = 0; i < 5; ++i) {
+        addi(1, R11);
+    }
+    ei();
+    addi(1, R11);
+    halt();
+
+    write_word(vm, 0x100, INTERRUPT_VECTORS + 2 * INTERRUPT_TIMER);
+    vm->pc = 0x100;
+    movi(1, R12);
+    halt();
+
+    vm->pc = 0;
+    vm_start(vm);
+
+    assert(vm->regfile[R11] == 5);
+    assert(vm->regfile[R12] == 1);
+
+    printf("    reads the count\n");
+    reset_vm();
+    assert(timer_attach(vm, &t) == 0);
+
+    movi(10, R10);
+    sti(R10, TIMER_RELOAD);
+    ldi(TIMER_COUNT, R11);
+    ldi(TIMER_RELOAD, R12);
+    halt();
+
+    vm->pc = 0;
+    vm_start(vm);
+
+    assert(vm->regfile[R11] == 9);
+    assert(vm->regfile[R12] == 10);
+
+    printf("    stops at reload 0\n");
+    reset_vm();
+    assert(timer_attach(vm, &t) == 0);
+
+    ei();
+    movi(2, R10);
+    sti(R10, TIMER_RELOAD);
+    movi(0, R10);
+    sti(R10, TIMER_RELOAD);
+    for (int i = 0; i < 4; ++i) {
+        addi(1, R11);
+    }
+    halt();
+
+    write_timer_handler();
+
+    vm->pc = 0;
+    vm_start(vm);
+
+    assert(vm->regfile[R11] == 4);
+    assert(vm->regfile[R12] == 0);
+
+    printf("    preempts a loop\n");
+    reset_vm();
+    assert(timer_attach(vm, &t) == 0);
+
+    write_timer_loop(7);
+    write_timer_handler();
+
+    vm->pc = 0;
+    vm_start(vm);
+
+    assert(vm->regfile[R11] == 100);
+    assert(vm->regfile[R12] > 30);
+    assert(vm->flags[IF] == 1);
+
+    printf("    preempts verified code\n");
+    reset_vm();
+    assert(timer_attach(vm, &t) == 0);
+
+    write_timer_loop(7);
+    write_timer_handler();
+
+    assert(verify_image(vm, 0) == 0);
+
+    vm->pc = 0;
+    vm_start(vm);
+
+    assert(vm->regfile[R11] == 100);
+    assert(vm->regfile[R12] > 30);
+
+    printf("    shares the countdown with the budget\n");
+    reset_vm();
+    assert(timer_attach(vm, &t) == 0);
+
+    write_timer_loop(7);
+    write_timer_handler();
+
+    vm->pc = 0;
+    vm->budget = 50;
+    assert(vm_execute(vm) == VM_BUDGET);
+    assert(vm->budget == 0);
+    vm->budget = -1;
+    assert(vm_execute(vm) == VM_HALTED);
+
+    assert(vm->regfile[R11] == 100);
+    assert(vm->regfile[R12] > 30);
+}
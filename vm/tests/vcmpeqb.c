@@ -0,0 +1,38 @@
+void test_vcmpeqb()
+{
+    printf("test_vcmpeqb\n");
+
+    printf("    sets a bit for every equal byte\n");
+    reset_vm();
+
+    memcpy(vm->ram + 0x1000, "abcdefghijklmnop", VECTOR_SIZE);
+    memcpy(vm->ram + 0x2000, "abXdefghijklmnoX", VECTOR_SIZE);
+
+    vm->regfile[R10] = 0x1000;
+    vm->regfile[R11] = 0x2000;
+    vcmpeqb(R10, R11, R12);
+    halt();
+
+    vm->pc = 0;
+    vm_start(vm);
+
+    assert(vm->regfile[R12] == 0x7ffb);
+
+    printf("    reads through devices\n");
+    reset_vm();
+
+    memcpy(vm->ram + 0x8000 - 8, "abcdefgh", 8);
+    memcpy(vm->ram + 0x2000, "abcdefgh\0\0\0\0\0\0\0\0", VECTOR_SIZE);
+
+    vm->regfile[R10] = 0x8000 - 8;
+    vm->regfile[R11] = 0x2000;
+    movi(1, R13);
+    bank(R13);
+    vcmpeqb(R10, R11, R12);
+    halt();
+
+    vm->pc = 0;
+    vm_start(vm);
+
+    assert(vm->regfile[R12] == 0xffff);
+}
@@ -0,0 +1,169 @@
+void test_verify()
+{
+    struct timer t;
+
+    printf("test_verify\n");
+
+    printf("    accepts well formed image\n");
+    reset_vm();
+
+    movi(10, R10);
+    call(20);
+    cmpi(0, R10);
+    jne(4);
+    halt();
+
+    vm->pc = 20;
+    subi(1, R10);
+    ret();
+
+    assert(verify_image(vm, 0) == 0);
+    assert(vm->verified == 1);
+
+    vm->pc = 0;
+    vm_start(vm);
+
+    assert(vm->regfile[R10] == 0);
+
+    printf("    rejects invalid register\n");
+    reset_vm();
+
+    movi(1, 0x20);
+    halt();
+
+    assert(verify_image(vm, 0) == -1);
+    assert(vm->verified == 0);
+
+    printf("    rejects unknown opcode\n");
+    reset_vm();
+
+    write_byte(vm, VM_OPCODE_COUNT, vm->pc++);
+
+    assert(verify_image(vm, 0) == -1);
+
+    printf("    rejects jump into the middle of an instruction\n");
+    reset_vm();
+
+    movi(1, R10);
+    jabs(1);
+
+    assert(verify_image(vm, 0) == -1);
+
+    printf("    follows relative branches\n");
+    reset_vm();
+
+    movi(3, R10);
+    subi(1, R10);
+    cmpi(0, R10);
+    brccs(BRNES, 4);
+    bsr(0x100);
+    halt();
+
+    vm->pc = 0x100;
+    movi(7, R11);
+    ret();
+
+    assert(verify_image(vm, 0) == 0);
+
+    vm->pc = 0;
+    vm_start(vm);
+
+    assert(vm->regfile[R10] == 0);
+    assert(vm->regfile[R11] == 7);
+
+    printf("    rejects relative branch into the middle of an instruction\n");
+    reset_vm();
+
+    movi(1, R10);
+    brs(1);
+
+    assert(verify_image(vm, 0) == -1);
+
+    printf("    rejects instruction past the end of ram\n");
+    reset_vm();
+
+    jabs(0xfffe);
+    vm->pc = 0xfffe;
+    write_byte(vm, MOVI, vm->pc++);
+    write_byte(vm, 0, vm->pc++);
+
+    assert(verify_image(vm, 0) == -1);
+
+    printf("    unverified image faults on invalid register\n");
+    reset_vm();
+
+    movi(1, 0xff);
+    movi(1, R10);
+    halt();
+
+    vm->pc = 0;
+    vm_start(vm);
+
+    assert(vm->regfile[R10] == 0);
+    assert(vm->pc == 4);
+
+    printf("    leaves unchecked mode on return to unverified code\n");
+    reset_vm();
+
+    pushi(10);
+    ret();
+
+    vm->pc = 10;
+    movi(1, 0xff);
+    movi(1, R10);
+    halt();
+
+    assert(verify_image(vm, 0) == 0);
+
+    vm->pc = 0;
+    vm_start(vm);
+
+    assert(vm->regfile[R10] == 0);
+
+    // The handler is not reachable from the entry point. A register byte
+    // patched after verification is masked by the unchecked dispatch but
+    // faults in checked mode, so R10 shows which one ran after IRET.
+    printf("    resumes unchecked mode after an interrupt\n");
+    reset_vm();
+
+    ei();
+    movi(1, R10);
+    halt();
+
+    write_word(vm, 0x100, INTERRUPT_VECTORS + 2 * INTERRUPT_TIMER);
+    vm->pc = 0x100;
+    iret();
+
+    assert(verify_image(vm, 0) == 0);
+    write_byte(vm, 0x10 | R10, instruction_size(vm, EI) + 3);
+    vm->interrupts = 1 << INTERRUPT_TIMER;
+
+    vm->pc = 0;
+    vm_start(vm);
+
+    assert(vm->regfile[R10] == 1);
+    assert(vm->regfile[RSP] == 0);
+
+    // DI at 0xffff leaves pc at 0x10000 as the timer ends the countdown.
+    // The dispatch mode has to be picked from the verified code at 0, not
+    // from block_buf, which follows code_map.
+    printf("    wraps pc when the countdown ends past the end of ram\n");
+    reset_vm();
+    assert(timer_attach(vm, &t) == 0);
+
+    movi(1, R10);
+    halt();
+
+    assert(verify_image(vm, 0) == 0);
+    write_byte(vm, 0x10 | R10, 3);
+    write_byte(vm, DI, 0xffff);
+    vm->block_buf[0] = CODE_NONE;
+    t.reload = 1;
+    t.left = 1;
+
+    vm->pc = 0xffff;
+    vm->budget = 100;
+    assert(vm_execute(vm) == VM_HALTED);
+
+    assert(vm->regfile[R10] == 1);
+}
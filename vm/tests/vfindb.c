@@ -0,0 +1,37 @@
+void test_vfindb()
+{
+    printf("test_vfindb\n");
+
+    printf("    finds the first match\n");
+    reset_vm();
+
+    memcpy(vm->ram + 0x1000, "key=value;x=y;zz", VECTOR_SIZE);
+
+    vm->regfile[R10] = ';';
+    vm->regfile[R11] = 0x1000;
+    vfindb(R10, R11, R12);
+    halt();
+
+    vm->pc = 0;
+    vm_start(vm);
+
+    assert(vm->regfile[R12] == 9);
+    assert(vm->flags[ZF] == 1);
+
+    printf("    reports a miss\n");
+    reset_vm();
+
+    memcpy(vm->ram + 0x1000, "key=value;x=y;zz", VECTOR_SIZE);
+    write_byte(vm, '#', 0x1000 + VECTOR_SIZE);
+
+    vm->regfile[R10] = '#';
+    vm->regfile[R11] = 0x1000;
+    vfindb(R10, R11, R12);
+    halt();
+
+    vm->pc = 0;
+    vm_start(vm);
+
+    assert(vm->regfile[R12] == VECTOR_SIZE);
+    assert(vm->flags[ZF] == 0);
+}
@@ -0,0 +1,50 @@
+void test_vminub()
+{
+    printf("test_vminub\n");
+
+    printf("    takes each minimum\n");
+    reset_vm();
+
+    for (int i = 0; i < VECTOR_SIZE + 1; ++i) {
+        write_byte(vm, i * 16, 0x1000 + i);
+        write_byte(vm, 0x80 + i, 0x2000 + i);
+    }
+
+    vm->regfile[R10] = 0x1000;
+    vm->regfile[R11] = 0x2000;
+    vminub(R10, R11);
+    halt();
+
+    vm->pc = 0;
+    vm_start(vm);
+
+    for (int i = 0; i < VECTOR_SIZE; ++i) {
+        uint8_t a = i * 16, b = 0x80 + i;
+
+        assert(read_byte(vm, 0x2000 + i) == (uint8_t) (a < b ? a : b));
+    }
+    assert(read_byte(vm, 0x2000 + VECTOR_SIZE) == 0x80 + VECTOR_SIZE);
+
+    printf("    wraps around the end of ram\n");
+    reset_vm();
+
+    for (int i = 0; i < VECTOR_SIZE; ++i) {
+        write_byte(vm, i * 16, 0x1000 + i);
+        write_byte(vm, 0x80 + i, 0xfff8 + i);
+    }
+
+    vm->pc = 0x100;
+    vm->regfile[R10] = 0x1000;
+    vm->regfile[R11] = 0xfff8;
+    vminub(R10, R11);
+    halt();
+
+    vm->pc = 0x100;
+    vm_start(vm);
+
+    for (int i = 0; i < VECTOR_SIZE; ++i) {
+        uint8_t a = i * 16, b = 0x80 + i;
+
+        assert(read_byte(vm, 0xfff8 + i) == (uint8_t) (a < b ? a : b));
+    }
+}
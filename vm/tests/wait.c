@@ -0,0 +1,60 @@
+void test_wait()
+{
+    struct timer t;
+
+    printf("test_wait\n");
+
+    printf("    returns to the host\n");
+    reset_vm();
+
+    wait();
+    movi(1, R10);
+    halt();
+
+    vm->pc = 0;
+    vm->budget = -1;
+    assert(vm_execute(vm) == VM_WAITING);
+
+    assert(vm->regfile[R10] == 0);
+    assert(vm->pc == 1);
+
+    printf("    goes on with an interrupt pending\n");
+    reset_vm();
+
+    vm->interrupts = 1 << 1;
+
+    wait();
+    movi(1, R10);
+    halt();
+
+    vm->pc = 0;
+    vm->budget = -1;
+    assert(vm_execute(vm) == VM_HALTED);
+
+    assert(vm->regfile[R10] == 1);
+    assert(vm->interrupts == 1 << 1);
+
+    printf("    sleeps until the timer fires\n");
+    reset_vm();
+    assert(timer_attach(vm, &t) == 0);
+
+    ei();
+    movi(1000, R10);
+    sti(R10, TIMER_RELOAD);
+    wait();
+    movi(2, R11);
+    halt();
+
+    write_word(vm, 0x100, INTERRUPT_VECTORS + 2 * INTERRUPT_TIMER);
+    vm->pc = 0x100;
+    movi(1, R12);
+    iret();
+
+    vm->pc = 0;
+    vm->budget = -1;
+    assert(vm_execute(vm) == VM_HALTED);
+
+    assert(vm->regfile[R11] == 2);
+    assert(vm->regfile[R12] == 1);
+    assert(t.left > 990);
+}
@@ -3,13 +3,13 @@ void test_xor()
     printf("test_xor\n");
     reset_vm();
 
-    regfile[R10] = 0xffff;
-    regfile[R11] = 0x0f0f;
+    vm->regfile[R10] = 0xffff;
+    vm->regfile[R11] = 0x0f0f;
     xor(R11, R10);
     halt();
 
-    pc = 0;
-    vm_start();
+    vm->pc = 0;
+    vm_start(vm);
 
-    assert(regfile[R10] == 0xf0f0);
+    assert(vm->regfile[R10] == 0xf0f0);
 }
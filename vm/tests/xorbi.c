@@ -3,12 +3,12 @@ void test_xorbi()
     printf("test_xorbi\n");
     reset_vm();
 
-    regfile[R10] = 0xabff;
+    vm->regfile[R10] = 0xabff;
     xorbi(0x0f, R10);
     halt();
 
-    pc = 0;
-    vm_start();
+    vm->pc = 0;
+    vm_start(vm);
 
-    assert(regfile[R10] == 0xabf0);
+    assert(vm->regfile[R10] == 0xabf0);
 }
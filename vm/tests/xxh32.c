@@ -0,0 +1,81 @@
+struct xxh32_test_case {
+    char *title;
+    char *data;
+    uint32_t seed;
+    uint32_t expect;
+};
+
+struct xxh32_test_case xxh32_cases[] = {
+    {
+        .title = "empty buffer",
+        .data = "",
+        .seed = 0,
+        .expect = 0x02cc5d05
+    },
+    {
+        .title = "short buffer",
+        .data = "abc",
+        .seed = 0,
+        .expect = 0x32d153ff
+    },
+    {
+        .title = "several 16 byte stripes and a tail",
+        .data = "The quick brown fox jumps over the lazy dog",
+        .seed = 0,
+        .expect = 0xe85ea4de
+    },
+    {
+        .title = "seed changes the hash",
+        .data = "123456789",
+        .seed = 0x1234,
+        .expect = 0x2e6722a0
+    }
+};
+
+void test_xxh32()
+{
+    printf("test_xxh32\n");
+
+    for (int i = 0; i < arrlen(xxh32_cases); ++i) {
+        struct xxh32_test_case tcase = xxh32_cases[i];
+        int len = strlen(tcase.data);
+
+        printf("    %s\n", tcase.title);
+        reset_vm();
+
+        memcpy(vm->ram + 0x1000, tcase.data, len);
+
+        vm->regfile[R10] = 0x1000;
+        vm->regfile[R11] = len;
+        vm->regfile[R12] = tcase.seed;
+        vm->regfile[R13] = tcase.seed >> 16;
+        xxh32(R10, R11, R12, R13);
+        halt();
+
+        vm->pc = 0;
+        vm_start(vm);
+
+        assert(vm->regfile[R12] == (uint16_t) tcase.expect);
+        assert(vm->regfile[R13] == tcase.expect >> 16);
+    }
+
+    printf("    wraps around the end of ram\n");
+    reset_vm();
+
+    for (int i = 0; i < 9; ++i) {
+        write_byte(vm, '1' + i, 0xfffc + i);
+    }
+
+    vm->pc = 0x100;
+    vm->regfile[R10] = 0xfffc;
+    vm->regfile[R11] = 9;
+    vm->regfile[R12] = 0x1234;
+    xxh32(R10, R11, R12, R13);
+    halt();
+
+    vm->pc = 0x100;
+    vm_start(vm);
+
+    assert(vm->regfile[R12] == 0x22a0);
+    assert(vm->regfile[R13] == 0x2e67);
+}
@@ -0,0 +1,4122 @@
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#ifdef __x86_64__
+#include <nmmintrin.h>
+#endif
+
+#include "vm.h"
+
+enum {
+    RAM_CAP = 1 << 16,
+
+    PAGE_BITS = 8,
+    PAGE_COUNT = RAM_CAP >> PAGE_BITS
+};
+
+enum vm_flag {
+    ZF,
+    SF,
+    CF,
+    OF,
+    IF,
+
+    VM_FLAG_COUNT
+};
+
+// A device sees every access to the pages it is mapped at. Accesses are
+// handed over in runs: a word load is one read of two bytes, not two reads
+// of one byte, and a run that covers several pages of the same device is a
+// single call. addr is the guest address of buf[0].
+struct device {
+    void (*read)(struct vm *vm, struct device *dev, uint16_t addr, uint8_t *buf, int len);
+    void (*write)(struct vm *vm, struct device *dev, uint16_t addr, uint8_t *buf, int len);
+    // Optional, called once when vm_start returns.
+    void (*halt)(struct vm *vm, struct device *dev);
+};
+
+struct console {
+    struct device dev;
+    int fd;
+    uint16_t head;
+    uint16_t tail;
+    int flushes;
+};
+
+struct file_window {
+    struct device dev;
+    uint8_t *map;
+    uint64_t size;
+    uint32_t offset;
+};
+
+struct timer {
+    struct device dev;
+    uint16_t reload;
+    // Instructions left until it fires as of the last clock_sync. The
+    // timer is stopped while reload is 0.
+    long left;
+};
+
+// A slot is free for the producer that claims position pos while seq ==
+// pos, and holds the message of that position for the receiver once seq ==
+// pos + 1. Releasing it sets seq to the position it serves next time round.
+struct channel_slot {
+    unsigned long seq;
+    unsigned long pos;
+    int len;
+};
+
+// Bounded multi-producer, single-consumer queue. Producers claim
+// positions by compare-and-swap on head, the receiver alone advances tail.
+// The padding keeps the two and the fields that never change on separate
+// cache lines, so senders and the receiver do not steal each other's.
+struct vm_channel {
+    unsigned long mask;
+    int size;
+    int stride;
+    struct vm *receiver;
+    uint8_t *slots;
+    char pad[64];
+    unsigned long head;
+    char pad2[64 - sizeof(unsigned long)];
+    unsigned long tail;
+};
+
+struct channel_port {
+    struct device dev;
+    struct vm_channel *channels[CHANNEL_COUNT];
+    uint16_t addr;
+    uint16_t len;
+    uint8_t status;
+    // Bit n is set when a send on endpoint n woke its receiver, until
+    // vm_woken hands the receiver to the host.
+    uint8_t woken;
+};
+
+// One machine. Everything the interpreter and the devices work on hangs
+// off it, so machines share nothing and different threads may run
+// different machines.
+struct vm {
+    // RAM_CAP bytes, see ram_init. Accesses that run past 0xffff wrap
+    // around to 0 in software.
+    uint8_t *ram;
+    // One enum code_mark per byte of ram. It is filled in by verify_image,
+    // and verified is set when the image passed. Entries outside code_lo
+    // to code_hi - 1 are all CODE_NONE.
+    uint8_t *code_map;
+    int code_lo;
+    int code_hi;
+    int verified;
+    uint16_t regfile[VM_REGISTER_COUNT];
+    int flags[VM_FLAG_COUNT];
+    int pc;
+    enum vm_encoding encoding;
+
+    // NULL entries are plain ram. word_device[p] is set when a word
+    // starting in page p can touch a device, i.e. when page p or page p + 1
+    // is mapped, so the word accessors also get away with a single lookup.
+    struct device *page_device[PAGE_COUNT];
+    struct device *word_device[PAGE_COUNT];
+
+    // Banks are allocated on the first store into them. Until then they
+    // read as zero. Bank 0 is never allocated, selecting it unmaps the
+    // window so the ram underneath is accessed directly again.
+    uint8_t *banks[BANK_COUNT];
+    int bank;
+
+    // Block instructions work on plain ram with the host's memmove, memset
+    // and memcmp. Ranges that wrap past 0xffff or touch a device are staged
+    // through these two RAM_CAP byte buffers by bus_transfer instead. They
+    // follow code_map in the machine's slot.
+    uint8_t *block_buf;
+    uint8_t *block_buf2;
+
+    // Instructions left in the host's budget, negative for no limit.
+    long budget;
+
+    // Counted down by every instruction a run with a budget or a timer
+    // executes. When it reaches zero vm_exec calls vm_event, which settles
+    // the instructions since the countdown was set, from slice, and starts
+    // the next one. The budget and the timer thus cost a single decrement.
+    long countdown;
+    long slice;
+
+    // NULL when the machine has no timer.
+    struct timer *timer;
+
+    // Bit n is set while interrupt n is pending.
+    uint8_t interrupts;
+
+    // Set when vm_exec returns VM_FAULT or VM_SYSCALL.
+    int exit_pc;
+    uint8_t syscall_number;
+
+    struct console console;
+    struct file_window file;
+    struct timer timer_device;
+    struct channel_port channel_port;
+    int channel_port_attached;
+
+    // Shared with vm_raise, which may be called from any thread.
+    uint8_t raised;
+    int waiting;
+
+    // Set by vm_set_log, NULL to stay quiet.
+    void (*log)(void *arg, const char *msg);
+    void *log_arg;
+};
+
+// Hands a message about what went wrong, a fault, an image that does not
+// verify or a device that failed, to the host's log callback.
+void vm_log(struct vm *vm, const char *fmt, ...)
+{
+    char msg[256];
+    va_list ap;
+
+    if (vm->log == NULL) {
+        return;
+    }
+
+    va_start(ap, fmt);
+    vsnprintf(msg, sizeof(msg), fmt, ap);
+    va_end(ap);
+
+    vm->log(vm->log_arg, msg);
+}
+
+// The memory of a machine, ram, code_map and the two block buffers, is one
+// slot of SLOT_SIZE bytes. Slots are carved out of chunks of ARENA_SLOTS,
+// each a single private anonymous mapping, so machines do not add mappings
+// of their own and the number of them is not bounded by the kernel's limit
+// on mappings per process. Pages a machine never stores to stay on the
+// kernel's shared zero page and cost nothing, so its footprint follows the
+// memory it actually uses. Chunks are kept for the life of the process, a
+// freed slot is handed back to the kernel page by page and reused first.
+enum {
+    SLOT_SIZE = 4 * RAM_CAP,
+    ARENA_SLOTS = 256
+};
+
+struct arena {
+    pthread_mutex_t lock;
+    uint8_t *chunk;
+    int used;
+    // Room for a slot from every chunk, so ram_free never has to grow it.
+    uint8_t **free;
+    int free_len;
+    int free_cap;
+};
+
+struct arena arena = {PTHREAD_MUTEX_INITIALIZER, NULL, ARENA_SLOTS, NULL, 0, 0};
+
+uint8_t *arena_alloc(void)
+{
+    uint8_t *slot;
+
+    pthread_mutex_lock(&arena.lock);
+
+    if (arena.free_len > 0) {
+        slot = arena.free[--arena.free_len];
+        pthread_mutex_unlock(&arena.lock);
+        return slot;
+    }
+
+    if (arena.used == ARENA_SLOTS) {
+        uint8_t **free;
+        uint8_t *chunk;
+
+        free = realloc(arena.free, (arena.free_cap + ARENA_SLOTS) * sizeof(*free));
+        if (free == NULL) {
+            pthread_mutex_unlock(&arena.lock);
+            return NULL;
+        }
+        arena.free = free;
+        arena.free_cap += ARENA_SLOTS;
+
+        chunk = mmap(NULL, (size_t) ARENA_SLOTS * SLOT_SIZE, PROT_READ | PROT_WRITE,
+                MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+        if (chunk == MAP_FAILED) {
+            pthread_mutex_unlock(&arena.lock);
+            return NULL;
+        }
+        arena.chunk = chunk;
+        arena.used = 0;
+    }
+
+    slot = arena.chunk + (size_t) arena.used++ * SLOT_SIZE;
+    pthread_mutex_unlock(&arena.lock);
+
+    return slot;
+}
+
+void arena_free(uint8_t *slot)
+{
+    madvise(slot, SLOT_SIZE, MADV_DONTNEED);
+
+    pthread_mutex_lock(&arena.lock);
+    arena.free[arena.free_len++] = slot;
+    pthread_mutex_unlock(&arena.lock);
+}
+
+int ram_init(struct vm *vm)
+{
+    uint8_t *slot;
+
+    slot = arena_alloc();
+    if (slot == NULL) {
+        errno = ENOMEM;
+        return -1;
+    }
+
+    vm->ram = slot;
+    vm->code_map = slot + RAM_CAP;
+    vm->code_lo = RAM_CAP;
+    vm->code_hi = 0;
+    vm->block_buf = vm->code_map + RAM_CAP;
+    vm->block_buf2 = vm->block_buf + RAM_CAP;
+
+    return 0;
+}
+
+void ram_free(struct vm *vm)
+{
+    arena_free(vm->ram);
+    vm->ram = NULL;
+    vm->code_map = NULL;
+    vm->block_buf = NULL;
+    vm->block_buf2 = NULL;
+}
+
+// Zeroes the pages of a page aligned private anonymous mapping that hold
+// base[start] to base[end - 1] by handing them back to the kernel.
+void anon_clear(uint8_t *base, long start, long end)
+{
+    long page;
+
+    page = sysconf(_SC_PAGESIZE);
+    start = start / page * page;
+    end = (end + page - 1) / page * page;
+
+    madvise(base + start, end - start, MADV_DONTNEED);
+}
+
+void write_byte(struct vm *vm, uint8_t val, uint16_t addr)
+{
+    vm->ram[addr] = val;
+}
+
+// Words are one unaligned 16-bit access. The compare for the word at 0xffff
+// is what wraparound costs now that ram has no mirror: about 15% on a loop
+// of word loads and stores, and the price of machines that add no mappings
+// of their own, see ram_init.
+void write_word(struct vm *vm, uint16_t val, uint16_t addr)
+{
+    if (addr == RAM_CAP - 1) {
+        vm->ram[addr] = val;
+        vm->ram[0] = val >> 8;
+        return;
+    }
+
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    val = (val << 8) | (val >> 8);
+#endif
+    memcpy(vm->ram + addr, &val, sizeof(val));
+}
+
+uint8_t read_byte(struct vm *vm, uint16_t addr)
+{
+    return vm->ram[addr];
+}
+
+uint16_t read_word(struct vm *vm, uint16_t addr)
+{
+    uint16_t val;
+
+    if (addr == RAM_CAP - 1) {
+        return vm->ram[addr] | vm->ram[0] << 8;
+    }
+
+    memcpy(&val, vm->ram + addr, sizeof(val));
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    val = (val << 8) | (val >> 8);
+#endif
+
+    return val;
+}
+
+// Fixed encoding instructions are fetched as one little endian word. They
+// are 4-byte aligned, so one never runs past 0xffff.
+uint32_t read_instruction(struct vm *vm, uint16_t addr)
+{
+    uint32_t val;
+
+    memcpy(&val, vm->ram + addr, sizeof(val));
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    val = __builtin_bswap32(val);
+#endif
+
+    return val;
+}
+
+// Copies len bytes between buf and ram at addr, wrapping around past 0xffff.
+void ram_transfer(struct vm *vm, uint16_t addr, uint8_t *buf, int len, int write)
+{
+    int n;
+
+    n = RAM_CAP - addr < len ? RAM_CAP - addr : len;
+
+    if (write) {
+        memcpy(vm->ram + addr, buf, n);
+        memcpy(vm->ram, buf + n, len - n);
+    } else {
+        memcpy(buf, vm->ram + addr, n);
+        memcpy(buf + n, vm->ram, len - n);
+    }
+}
+
+// Maps dev over len bytes starting at addr; both must be page aligned. A
+// NULL dev turns the pages back into plain ram.
+int bus_map(struct vm *vm, struct device *dev, uint16_t addr, int len)
+{
+    int first, count;
+
+    if (addr % (1 << PAGE_BITS) != 0 || len % (1 << PAGE_BITS) != 0 ||
+            len <= 0 || addr + len > RAM_CAP) {
+        vm_log(vm, "bus: bad mapping of %d bytes at ram[%d]", len, addr);
+        return -1;
+    }
+
+    first = addr >> PAGE_BITS;
+    count = len >> PAGE_BITS;
+
+    for (int p = first; p < first + count; ++p) {
+        vm->page_device[p] = dev;
+    }
+
+    // Words starting in the page before the range may spill into it.
+    for (int i = first - 1; i < first + count; ++i) {
+        int p;
+        struct device *next;
+
+        p = (i + PAGE_COUNT) % PAGE_COUNT;
+        next = vm->page_device[(p + 1) % PAGE_COUNT];
+        vm->word_device[p] = vm->page_device[p] != NULL ? vm->page_device[p] : next;
+    }
+
+    return 0;
+}
+
+void bus_halt(struct vm *vm)
+{
+    struct device *last;
+
+    last = NULL;
+    for (int p = 0; p < PAGE_COUNT; ++p) {
+        struct device *dev;
+
+        dev = vm->page_device[p];
+        if (dev != NULL && dev != last && dev->halt != NULL) {
+            dev->halt(vm, dev);
+        }
+        last = dev;
+    }
+}
+
+// Slow path of the load/store accessors: splits [addr, addr + len) into
+// runs of pages that belong to the same device (or to ram) and hands each
+// run over at once.
+void bus_transfer(struct vm *vm, uint16_t addr, uint8_t *buf, int len, int write)
+{
+    while (len > 0) {
+        struct device *dev;
+        int n;
+
+        dev = vm->page_device[addr >> PAGE_BITS];
+        n = (1 << PAGE_BITS) - (addr & ((1 << PAGE_BITS) - 1));
+
+        while (n < len && addr + n < RAM_CAP &&
+                vm->page_device[(addr + n) >> PAGE_BITS] == dev) {
+            n += 1 << PAGE_BITS;
+        }
+
+        if (n > len) {
+            n = len;
+        }
+
+        if (dev == NULL && write) {
+            memcpy(vm->ram + addr, buf, n);
+        } else if (dev == NULL) {
+            memcpy(buf, vm->ram + addr, n);
+        } else if (write) {
+            dev->write(vm, dev, addr, buf, n);
+        } else {
+            dev->read(vm, dev, addr, buf, n);
+        }
+
+        addr += n;
+        buf += n;
+        len -= n;
+    }
+}
+
+int bus_is_ram(struct vm *vm, uint16_t addr, int len)
+{
+    for (int p = addr >> PAGE_BITS; p <= (addr + len - 1) >> PAGE_BITS; ++p) {
+        if (vm->page_device[p % PAGE_COUNT] != NULL) {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+// Data accessors used by the load/store instructions. Instruction fetch and
+// the stack go straight to ram, so code and stack must live in ram pages.
+uint8_t load_byte(struct vm *vm, uint16_t addr)
+{
+    uint8_t val;
+
+    if (vm->page_device[addr >> PAGE_BITS] == NULL) {
+        return vm->ram[addr];
+    }
+
+    bus_transfer(vm, addr, &val, 1, 0);
+
+    return val;
+}
+
+uint16_t load_word(struct vm *vm, uint16_t addr)
+{
+    uint8_t buf[2];
+
+    if (vm->word_device[addr >> PAGE_BITS] == NULL) {
+        return read_word(vm, addr);
+    }
+
+    bus_transfer(vm, addr, buf, 2, 0);
+
+    return (buf[1] << 8) | buf[0];
+}
+
+void store_byte(struct vm *vm, uint8_t val, uint16_t addr)
+{
+    if (vm->page_device[addr >> PAGE_BITS] == NULL) {
+        vm->ram[addr] = val;
+        return;
+    }
+
+    bus_transfer(vm, addr, &val, 1, 1);
+}
+
+void store_word(struct vm *vm, uint16_t val, uint16_t addr)
+{
+    uint8_t buf[2];
+
+    if (vm->word_device[addr >> PAGE_BITS] == NULL) {
+        write_word(vm, val, addr);
+        return;
+    }
+
+    buf[0] = val;
+    buf[1] = val >> 8;
+    bus_transfer(vm, addr, buf, 2, 1);
+}
+
+void console_flush(struct vm *vm, struct console *con)
+{
+    while (con->head != con->tail) {
+        struct iovec iov[2];
+        int iovcnt, start, pending;
+        ssize_t n;
+
+        pending = (uint16_t) (con->tail - con->head);
+        if (pending > CONSOLE_RING_SIZE) {
+            // The guest overran the ring, only the last lap is still there.
+            con->head = con->tail - CONSOLE_RING_SIZE;
+            pending = CONSOLE_RING_SIZE;
+        }
+
+        start = con->head % CONSOLE_RING_SIZE;
+        iov[0].iov_base = vm->ram + CONSOLE_RING + start;
+        iov[0].iov_len = pending;
+        iovcnt = 1;
+
+        if (start + pending > CONSOLE_RING_SIZE) {
+            iov[0].iov_len = CONSOLE_RING_SIZE - start;
+            iov[1].iov_base = vm->ram + CONSOLE_RING;
+            iov[1].iov_len = pending - iov[0].iov_len;
+            iovcnt = 2;
+        }
+
+        n = writev(con->fd, iov, iovcnt);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            vm_log(vm, "console: %s", strerror(errno));
+            con->head = con->tail;
+            break;
+        }
+
+        con->head += n;
+        con->flushes++;
+    }
+}
+
+void console_read(struct vm *vm, struct device *dev, uint16_t addr, uint8_t *buf, int len)
+{
+    struct console *con = (struct console *) dev;
+    uint8_t regs[CONSOLE_FLUSH - CONSOLE_PORT + 1];
+
+    (void) vm;
+
+    memset(regs, 0, sizeof(regs));
+    regs[CONSOLE_HEAD - CONSOLE_PORT] = con->head;
+    regs[CONSOLE_HEAD - CONSOLE_PORT + 1] = con->head >> 8;
+    regs[CONSOLE_TAIL - CONSOLE_PORT] = con->tail;
+    regs[CONSOLE_TAIL - CONSOLE_PORT + 1] = con->tail >> 8;
+
+    for (int i = 0; i < len; ++i) {
+        int off = (uint16_t) (addr + i) - CONSOLE_PORT;
+
+        buf[i] = off < (int) sizeof(regs) ? regs[off] : 0;
+    }
+}
+
+void console_write(struct vm *vm, struct device *dev, uint16_t addr, uint8_t *buf, int len)
+{
+    struct console *con = (struct console *) dev;
+    int flush;
+
+    flush = 0;
+    for (int i = 0; i < len; ++i) {
+        int off = (uint16_t) (addr + i) - CONSOLE_PORT;
+
+        if (off == CONSOLE_TAIL - CONSOLE_PORT) {
+            con->tail = (con->tail & 0xff00) | buf[i];
+        } else if (off == CONSOLE_TAIL - CONSOLE_PORT + 1) {
+            con->tail = (con->tail & 0x00ff) | (buf[i] << 8);
+        } else if (off == CONSOLE_FLUSH - CONSOLE_PORT) {
+            flush = 1;
+        }
+    }
+
+    if (flush || (uint16_t) (con->tail - con->head) >= CONSOLE_RING_SIZE) {
+        console_flush(vm, con);
+    }
+}
+
+void console_halt(struct vm *vm, struct device *dev)
+{
+    console_flush(vm, (struct console *) dev);
+}
+
+int console_attach(struct vm *vm, struct console *con, int fd)
+{
+    memset(con, 0, sizeof(*con));
+    con->dev.read = console_read;
+    con->dev.write = console_write;
+    con->dev.halt = console_halt;
+    con->fd = fd;
+
+    return bus_map(vm, &con->dev, CONSOLE_PORT, 1 << PAGE_BITS);
+}
+
+void file_read(struct vm *vm, struct device *dev, uint16_t addr, uint8_t *buf, int len)
+{
+    struct file_window *fw = (struct file_window *) dev;
+    uint64_t pos;
+    int n;
+
+    (void) vm;
+
+    if (addr >= FILE_PORT) {
+        uint8_t regs[FILE_SIZE - FILE_PORT + 6];
+
+        for (int i = 0; i < 4; ++i) {
+            regs[FILE_OFFSET - FILE_PORT + i] = fw->offset >> (8 * i);
+        }
+        for (int i = 0; i < 6; ++i) {
+            regs[FILE_SIZE - FILE_PORT + i] = fw->size >> (8 * i);
+        }
+
+        for (int i = 0; i < len; ++i) {
+            int off = addr + i - FILE_PORT;
+
+            buf[i] = off < (int) sizeof(regs) ? regs[off] : 0;
+        }
+        return;
+    }
+
+    // Loads are served straight from the page cache, the file is never
+    // copied into guest ram.
+    pos = ((uint64_t) fw->offset << PAGE_BITS) + (addr - FILE_WINDOW);
+    n = 0;
+    if (pos < fw->size) {
+        n = fw->size - pos < (uint64_t) len ? (int) (fw->size - pos) : len;
+        memcpy(buf, fw->map + pos, n);
+    }
+    memset(buf + n, 0, len - n);
+}
+
+void file_write(struct vm *vm, struct device *dev, uint16_t addr, uint8_t *buf, int len)
+{
+    struct file_window *fw = (struct file_window *) dev;
+
+    (void) vm;
+
+    // The window itself is read only.
+    for (int i = 0; i < len; ++i) {
+        int off = (uint16_t) (addr + i) - FILE_OFFSET;
+
+        if (off >= 0 && off < 4) {
+            fw->offset &= ~((uint32_t) 0xff << (8 * off));
+            fw->offset |= (uint32_t) buf[i] << (8 * off);
+        }
+    }
+}
+
+int file_attach(struct vm *vm, struct file_window *fw, const char *path)
+{
+    struct stat st;
+    int fd;
+
+    memset(fw, 0, sizeof(*fw));
+    fw->dev.read = file_read;
+    fw->dev.write = file_write;
+
+    fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        vm_log(vm, "%s: %s", path, strerror(errno));
+        return -1;
+    }
+
+    if (fstat(fd, &st) != 0) {
+        vm_log(vm, "%s: %s", path, strerror(errno));
+        close(fd);
+        return -1;
+    }
+
+    fw->size = st.st_size;
+    if (fw->size > 0) {
+        fw->map = mmap(NULL, fw->size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (fw->map == MAP_FAILED) {
+            vm_log(vm, "%s: %s", path, strerror(errno));
+            close(fd);
+            return -1;
+        }
+        madvise(fw->map, fw->size, MADV_SEQUENTIAL);
+    }
+
+    close(fd);
+
+    if (bus_map(vm, &fw->dev, FILE_WINDOW, FILE_WINDOW_SIZE) != 0 ||
+            bus_map(vm, &fw->dev, FILE_PORT, 1 << PAGE_BITS) != 0) {
+        return -1;
+    }
+
+    return 0;
+}
+
+void file_detach(struct file_window *fw)
+{
+    if (fw->map != NULL) {
+        munmap(fw->map, fw->size);
+        fw->map = NULL;
+    }
+}
+
+void bank_read(struct vm *vm, struct device *dev, uint16_t addr, uint8_t *buf, int len)
+{
+    (void) dev;
+
+    if (vm->banks[vm->bank] == NULL) {
+        memset(buf, 0, len);
+        return;
+    }
+
+    memcpy(buf, vm->banks[vm->bank] + (addr - BANK_WINDOW), len);
+}
+
+void bank_write(struct vm *vm, struct device *dev, uint16_t addr, uint8_t *buf, int len)
+{
+    (void) dev;
+
+    if (vm->banks[vm->bank] == NULL) {
+        vm->banks[vm->bank] = calloc(1, BANK_SIZE);
+        if (vm->banks[vm->bank] == NULL) {
+            vm_log(vm, "bank: %s", strerror(errno));
+            return;
+        }
+    }
+
+    memcpy(vm->banks[vm->bank] + (addr - BANK_WINDOW), buf, len);
+}
+
+struct device bank_device = {
+    .read = bank_read,
+    .write = bank_write
+};
+
+void bank_select(struct vm *vm, int n)
+{
+    if ((n == 0) != (vm->bank == 0)) {
+        bus_map(vm, n == 0 ? NULL : &bank_device, BANK_WINDOW, BANK_SIZE);
+    }
+
+    vm->bank = n;
+}
+
+void bank_reset(struct vm *vm)
+{
+    for (int i = 0; i < BANK_COUNT; ++i) {
+        free(vm->banks[i]);
+        vm->banks[i] = NULL;
+    }
+
+    vm->bank = 0;
+}
+
+void clock_sync(struct vm *vm)
+{
+    long used;
+
+    used = vm->slice - vm->countdown;
+    vm->slice = vm->countdown;
+
+    if (vm->budget > 0) {
+        vm->budget -= used;
+    }
+    if (vm->timer != NULL && vm->timer->reload != 0) {
+        vm->timer->left -= used;
+    }
+}
+
+// Sets the countdown to the next event. An interrupt that can be taken
+// right away is due before the next instruction.
+void clock_schedule(struct vm *vm)
+{
+    long next;
+
+    clock_sync(vm);
+
+    next = vm->budget < 0 ? LONG_MAX : vm->budget;
+    if (vm->timer != NULL && vm->timer->reload != 0 && vm->timer->left < next) {
+        next = vm->timer->left;
+    }
+    if (vm->interrupts != 0 && vm->flags[IF]) {
+        next = 0;
+    }
+
+    vm->countdown = vm->slice = next;
+}
+
+void timer_read(struct vm *vm, struct device *dev, uint16_t addr, uint8_t *buf, int len)
+{
+    struct timer *t = (struct timer *) dev;
+    uint8_t regs[TIMER_COUNT - TIMER_PORT + 2];
+    uint16_t count;
+
+    clock_sync(vm);
+    count = t->left;
+
+    regs[TIMER_RELOAD - TIMER_PORT] = t->reload;
+    regs[TIMER_RELOAD - TIMER_PORT + 1] = t->reload >> 8;
+    regs[TIMER_COUNT - TIMER_PORT] = count;
+    regs[TIMER_COUNT - TIMER_PORT + 1] = count >> 8;
+
+    for (int i = 0; i < len; ++i) {
+        int off = (uint16_t) (addr + i) - TIMER_PORT;
+
+        buf[i] = off < (int) sizeof(regs) ? regs[off] : 0;
+    }
+}
+
+void timer_write(struct vm *vm, struct device *dev, uint16_t addr, uint8_t *buf, int len)
+{
+    struct timer *t = (struct timer *) dev;
+    int armed;
+
+    armed = 0;
+    for (int i = 0; i < len; ++i) {
+        int off = (uint16_t) (addr + i) - TIMER_PORT;
+
+        if (off == TIMER_RELOAD - TIMER_PORT) {
+            t->reload = (t->reload & 0xff00) | buf[i];
+            armed = 1;
+        } else if (off == TIMER_RELOAD - TIMER_PORT + 1) {
+            t->reload = (t->reload & 0x00ff) | (buf[i] << 8);
+            armed = 1;
+        }
+    }
+
+    if (armed) {
+        clock_sync(vm);
+        t->left = t->reload;
+        clock_schedule(vm);
+    }
+}
+
+int timer_attach(struct vm *vm, struct timer *t)
+{
+    memset(t, 0, sizeof(*t));
+    t->dev.read = timer_read;
+    t->dev.write = timer_write;
+    vm->timer = t;
+
+    return bus_map(vm, &t->dev, TIMER_PORT, 1 << PAGE_BITS);
+}
+
+struct channel_slot *channel_slot(struct vm_channel *ch, unsigned long pos)
+{
+    return (struct channel_slot *) (ch->slots + (pos & ch->mask) * ch->stride);
+}
+
+uint8_t *channel_data(struct channel_slot *slot)
+{
+    return (uint8_t *) (slot + 1);
+}
+
+// The next free slot for a message, NULL when the queue is full.
+struct channel_slot *channel_claim(struct vm_channel *ch)
+{
+    unsigned long pos;
+
+    pos = __atomic_load_n(&ch->head, __ATOMIC_RELAXED);
+    for (;;) {
+        struct channel_slot *slot;
+        long diff;
+
+        slot = channel_slot(ch, pos);
+        diff = (long) (__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) - pos);
+
+        if (diff < 0) {
+            return NULL;
+        }
+
+        if (diff == 0 && __atomic_compare_exchange_n(&ch->head, &pos, pos + 1,
+                    1, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+            slot->pos = pos;
+            return slot;
+        }
+
+        if (diff > 0) {
+            pos = __atomic_load_n(&ch->head, __ATOMIC_RELAXED);
+        }
+    }
+}
+
+// Returns 1 if the message woke the receiving machine, see vm_raise.
+int channel_publish(struct vm_channel *ch, struct channel_slot *slot, int len)
+{
+    slot->len = len;
+    __atomic_store_n(&slot->seq, slot->pos + 1, __ATOMIC_RELEASE);
+
+    if (ch->receiver == NULL) {
+        return 0;
+    }
+
+    return vm_raise(ch->receiver, INTERRUPT_CHANNEL);
+}
+
+// The oldest message, NULL when the queue is empty.
+struct channel_slot *channel_peek(struct vm_channel *ch)
+{
+    struct channel_slot *slot;
+
+    slot = channel_slot(ch, ch->tail);
+    if (__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) != ch->tail + 1) {
+        return NULL;
+    }
+
+    return slot;
+}
+
+void channel_release(struct vm_channel *ch, struct channel_slot *slot)
+{
+    ch->tail++;
+    __atomic_store_n(&slot->seq, slot->pos + ch->mask + 1, __ATOMIC_RELEASE);
+}
+
+// Messages are copied straight between the queue and the guest's ram.
+int channel_port_send(struct vm *vm, struct channel_port *port, int n)
+{
+    struct vm_channel *ch;
+    struct channel_slot *slot;
+
+    ch = n < CHANNEL_COUNT ? port->channels[n] : NULL;
+    if (ch == NULL || port->len > ch->size) {
+        return 0;
+    }
+
+    slot = channel_claim(ch);
+    if (slot == NULL) {
+        return 0;
+    }
+
+    bus_transfer(vm, port->addr, channel_data(slot), port->len, 0);
+    if (channel_publish(ch, slot, port->len)) {
+        port->woken |= 1 << n;
+    }
+
+    return 1;
+}
+
+// Only the machine attached as the receiver may take messages off the
+// queue, it has a single consumer.
+int channel_port_receive(struct vm *vm, struct channel_port *port, int n)
+{
+    struct vm_channel *ch;
+    struct channel_slot *slot;
+
+    ch = n < CHANNEL_COUNT ? port->channels[n] : NULL;
+    if (ch == NULL || ch->receiver != vm) {
+        return 0;
+    }
+
+    slot = channel_peek(ch);
+    if (slot == NULL) {
+        return 0;
+    }
+
+    if (slot->len < port->len) {
+        port->len = slot->len;
+    }
+    bus_transfer(vm, port->addr, channel_data(slot), port->len, 1);
+    channel_release(ch, slot);
+
+    return 1;
+}
+
+void channel_port_read(struct vm *vm, struct device *dev, uint16_t addr, uint8_t *buf, int len)
+{
+    struct channel_port *port = (struct channel_port *) dev;
+    uint8_t regs[CHANNEL_STATUS - CHANNEL_PORT + 1];
+
+    (void) vm;
+
+    memset(regs, 0, sizeof(regs));
+    regs[CHANNEL_ADDR - CHANNEL_PORT] = port->addr;
+    regs[CHANNEL_ADDR - CHANNEL_PORT + 1] = port->addr >> 8;
+    regs[CHANNEL_LEN - CHANNEL_PORT] = port->len;
+    regs[CHANNEL_LEN - CHANNEL_PORT + 1] = port->len >> 8;
+    regs[CHANNEL_STATUS - CHANNEL_PORT] = port->status;
+
+    for (int i = 0; i < len; ++i) {
+        int off = (uint16_t) (addr + i) - CHANNEL_PORT;
+
+        buf[i] = off < (int) sizeof(regs) ? regs[off] : 0;
+    }
+}
+
+void channel_port_write(struct vm *vm, struct device *dev, uint16_t addr, uint8_t *buf, int len)
+{
+    struct channel_port *port = (struct channel_port *) dev;
+
+    for (int i = 0; i < len; ++i) {
+        int off = (uint16_t) (addr + i) - CHANNEL_PORT;
+
+        if (off == CHANNEL_ADDR - CHANNEL_PORT) {
+            port->addr = (port->addr & 0xff00) | buf[i];
+        } else if (off == CHANNEL_ADDR - CHANNEL_PORT + 1) {
+            port->addr = (port->addr & 0x00ff) | (buf[i] << 8);
+        } else if (off == CHANNEL_LEN - CHANNEL_PORT) {
+            port->len = (port->len & 0xff00) | buf[i];
+        } else if (off == CHANNEL_LEN - CHANNEL_PORT + 1) {
+            port->len = (port->len & 0x00ff) | (buf[i] << 8);
+        } else if (off == CHANNEL_SEND - CHANNEL_PORT) {
+            port->status = channel_port_send(vm, port, buf[i]);
+        } else if (off == CHANNEL_RECEIVE - CHANNEL_PORT) {
+            port->status = channel_port_receive(vm, port, buf[i]);
+        }
+    }
+}
+
+int channel_port_attach(struct vm *vm, struct channel_port *port)
+{
+    memset(port, 0, sizeof(*port));
+    port->dev.read = channel_port_read;
+    port->dev.write = channel_port_write;
+
+    return bus_map(vm, &port->dev, CHANNEL_PORT, 1 << PAGE_BITS);
+}
+
+void stack_push(struct vm *vm, uint16_t val)
+{
+    vm->regfile[RSP] -= 2;
+    write_word(vm, val, vm->regfile[RSP]);
+}
+
+uint16_t stack_pop(struct vm *vm)
+{
+    uint16_t val;
+
+    val = read_word(vm, vm->regfile[RSP]);
+    vm->regfile[RSP] += 2;
+
+    return val;
+}
+
+// PUSHM and POPM move every register in mask with one copy. The layout is
+// the same as PUSH of each register in ascending order, so the highest one
+// ends up at RSP.
+void stack_push_mask(struct vm *vm, uint16_t mask)
+{
+    uint8_t buf[2 * VM_REGISTER_COUNT];
+    int n;
+
+    n = 0;
+    for (int r = VM_REGISTER_COUNT - 1; r >= 0; --r) {
+        if (mask & (1 << r)) {
+            buf[n++] = vm->regfile[r];
+            buf[n++] = vm->regfile[r] >> 8;
+        }
+    }
+
+    vm->regfile[RSP] -= n;
+    ram_transfer(vm, vm->regfile[RSP], buf, n, 1);
+}
+
+// A saved RSP is dropped rather than restored, RSP ends up just past the
+// popped block.
+void stack_pop_mask(struct vm *vm, uint16_t mask)
+{
+    uint8_t buf[2 * VM_REGISTER_COUNT];
+    int n;
+
+    n = 0;
+    for (int r = 0; r < VM_REGISTER_COUNT; ++r) {
+        if (mask & (1 << r)) {
+            n += 2;
+        }
+    }
+
+    ram_transfer(vm, vm->regfile[RSP], buf, n, 0);
+    vm->regfile[RSP] += n;
+
+    n = 0;
+    for (int r = VM_REGISTER_COUNT - 1; r >= 0; --r) {
+        if (mask & (1 << r)) {
+            if (r != RSP) {
+                vm->regfile[r] = buf[n] | buf[n + 1] << 8;
+            }
+            n += 2;
+        }
+    }
+}
+
+void decode_registers(uint8_t byte, enum vm_register *r1, enum vm_register *r2)
+{
+    *r1 = byte >> 4;
+    *r2 = byte & 0x0f;
+}
+
+void register_write_byte(struct vm *vm, enum vm_register r, uint8_t val)
+{
+    vm->regfile[r] = (vm->regfile[r] & 0xff00) | val;
+}
+
+// CF is set when a - b does not borrow, that is when a >= b unsigned. Byte
+// operands come in sign extended, which keeps their unsigned order.
+void set_flags(struct vm *vm, int16_t a, int16_t b, int16_t t)
+{
+    vm->flags[ZF] = t == 0;
+    vm->flags[SF] = t < 0;
+    vm->flags[OF] = (a < 0 && b >= 0 && t >= 0) || (a >= 0 && b < 0 && t < 0);
+    vm->flags[CF] = (uint16_t) a >= (uint16_t) b;
+}
+
+// Flags of a + b + carry at the width given by mask (0xffff or 0xff). CF
+// is the carry out, so ADC can chain limbs of a wider addition.
+void set_add_flags(struct vm *vm, uint16_t a, uint16_t b, int carry, uint16_t mask)
+{
+    uint32_t t;
+    uint16_t sign;
+
+    a &= mask;
+    b &= mask;
+    t = (uint32_t) a + b + carry;
+    sign = mask ^ (mask >> 1);
+
+    vm->flags[ZF] = (t & mask) == 0;
+    vm->flags[SF] = (t & sign) != 0;
+    vm->flags[OF] = (~(a ^ b) & (a ^ t) & sign) != 0;
+    vm->flags[CF] = t > mask;
+}
+
+// Flags of a - b - borrow at the width given by mask. CF has the same
+// meaning as after CMP: it is set when nothing was borrowed, so SBB
+// subtracts !CF.
+void set_sub_flags(struct vm *vm, uint16_t a, uint16_t b, int borrow, uint16_t mask)
+{
+    uint32_t t;
+    uint16_t sign;
+
+    a &= mask;
+    b &= mask;
+    t = (uint32_t) a - b - borrow;
+    sign = mask ^ (mask >> 1);
+
+    vm->flags[ZF] = (t & mask) == 0;
+    vm->flags[SF] = (t & sign) != 0;
+    vm->flags[OF] = ((a ^ b) & (a ^ t) & sign) != 0;
+    vm->flags[CF] = (uint32_t) a >= (uint32_t) b + borrow;
+}
+
+// Whether the flags satisfy c, tested the same way as the matching Jcc.
+int condition(struct vm *vm, enum vm_condition c)
+{
+    switch (c) {
+    case COND_E:
+        return vm->flags[ZF];
+    case COND_NE:
+        return !vm->flags[ZF];
+    case COND_G:
+        return !(vm->flags[SF] ^ vm->flags[OF]) && !vm->flags[ZF];
+    case COND_GE:
+        return !(vm->flags[SF] ^ vm->flags[OF]);
+    case COND_L:
+        return vm->flags[SF] ^ vm->flags[OF];
+    case COND_LE:
+        return (vm->flags[SF] ^ vm->flags[OF]) || vm->flags[ZF];
+    case COND_A:
+        return vm->flags[CF] && !vm->flags[ZF];
+    case COND_AE:
+        return vm->flags[CF];
+    case COND_B:
+        return !vm->flags[CF];
+    default:
+        return !vm->flags[CF] || vm->flags[ZF];
+    }
+}
+
+int block_direct(struct vm *vm, uint16_t addr, int len)
+{
+    return addr + len <= RAM_CAP && bus_is_ram(vm, addr, len);
+}
+
+void block_move(struct vm *vm, uint16_t src, uint16_t dst, int len)
+{
+    if (len == 0) {
+        return;
+    }
+
+    if (block_direct(vm, src, len) && block_direct(vm, dst, len)) {
+        memmove(vm->ram + dst, vm->ram + src, len);
+        return;
+    }
+
+    bus_transfer(vm, src, vm->block_buf, len, 0);
+    bus_transfer(vm, dst, vm->block_buf, len, 1);
+}
+
+void block_fill(struct vm *vm, uint8_t val, uint16_t dst, int len)
+{
+    if (len == 0) {
+        return;
+    }
+
+    if (block_direct(vm, dst, len)) {
+        memset(vm->ram + dst, val, len);
+        return;
+    }
+
+    memset(vm->block_buf, val, len);
+    bus_transfer(vm, dst, vm->block_buf, len, 1);
+}
+
+// Contiguous view of len bytes at addr: ram itself when the range allows,
+// otherwise a copy gathered into buf.
+uint8_t *block_read(struct vm *vm, uint16_t addr, int len, uint8_t *buf)
+{
+    if (block_direct(vm, addr, len)) {
+        return vm->ram + addr;
+    }
+
+    bus_transfer(vm, addr, buf, len, 0);
+
+    return buf;
+}
+
+// Index of the first byte where a and b differ, len if there is none.
+int block_mismatch(uint8_t *a, uint8_t *b, int len)
+{
+    int i;
+
+    i = 0;
+
+#ifdef __SSE2__
+    for (; len - i >= 16; i += 16) {
+        __m128i va, vb;
+        int mask;
+
+        va = _mm_loadu_si128((__m128i *) (a + i));
+        vb = _mm_loadu_si128((__m128i *) (b + i));
+        mask = _mm_movemask_epi8(_mm_cmpeq_epi8(va, vb));
+
+        if (mask != 0xffff) {
+            return i + __builtin_ctz(~mask);
+        }
+    }
+#endif
+
+    for (; i < len && a[i] == b[i]; ++i) {
+    }
+
+    return i;
+}
+
+// Sets the flags like CMPB of the first pair of bytes that differ, a
+// against b, and returns their index. Equal blocks compare like equal
+// bytes and return len.
+int block_compare(struct vm *vm, uint16_t b, uint16_t a, int len)
+{
+    uint8_t *pa, *pb;
+    int i;
+
+    pa = block_read(vm, a, len, vm->block_buf);
+    pb = block_read(vm, b, len, vm->block_buf2);
+
+    i = block_mismatch(pa, pb, len);
+
+    if (i == len) {
+        set_sub_flags(vm, 0, 0, 0, 0xff);
+    } else {
+        set_sub_flags(vm, pa[i], pb[i], 0, 0xff);
+    }
+
+    return i;
+}
+
+// Index of the first byte equal to val, len if there is none.
+int block_scan(struct vm *vm, uint8_t val, uint16_t addr, int len)
+{
+    uint8_t *p, *hit;
+
+    p = block_read(vm, addr, len, vm->block_buf);
+    hit = memchr(p, val, len);
+
+    return hit == NULL ? len : hit - p;
+}
+
+// Vectors in plain ram are used in place. One that wraps around past 0xffff
+// or touches a device is staged in buf.
+uint8_t *vector_load(struct vm *vm, uint16_t addr, uint8_t *buf)
+{
+    if (block_direct(vm, addr, VECTOR_SIZE)) {
+        return vm->ram + addr;
+    }
+
+    bus_transfer(vm, addr, buf, VECTOR_SIZE, 0);
+
+    return buf;
+}
+
+void vector_store(struct vm *vm, uint16_t addr, uint8_t *v)
+{
+    if (v != vm->ram + addr) {
+        bus_transfer(vm, addr, v, VECTOR_SIZE, 1);
+    }
+}
+
+enum vector_op {
+    VECTOR_ADD,
+    VECTOR_MIN,
+    VECTOR_MAX
+};
+
+// dst = dst op src, bytewise. Both vectors are read before dst is written,
+// so overlapping operands behave the same with and without SSE2.
+void vector_apply(enum vector_op op, uint8_t *dst, uint8_t *src)
+{
+#ifdef __SSE2__
+    __m128i a, b, t;
+
+    a = _mm_loadu_si128((__m128i *) dst);
+    b = _mm_loadu_si128((__m128i *) src);
+
+    switch (op) {
+    case VECTOR_ADD:
+        t = _mm_add_epi8(a, b);
+        break;
+    case VECTOR_MIN:
+        t = _mm_min_epu8(a, b);
+        break;
+    default:
+        t = _mm_max_epu8(a, b);
+        break;
+    }
+
+    _mm_storeu_si128((__m128i *) dst, t);
+#else
+    uint8_t b[VECTOR_SIZE];
+
+    memcpy(b, src, VECTOR_SIZE);
+
+    for (int i = 0; i < VECTOR_SIZE; ++i) {
+        switch (op) {
+        case VECTOR_ADD:
+            dst[i] += b[i];
+            break;
+        case VECTOR_MIN:
+            dst[i] = dst[i] < b[i] ? dst[i] : b[i];
+            break;
+        default:
+            dst[i] = dst[i] > b[i] ? dst[i] : b[i];
+            break;
+        }
+    }
+#endif
+}
+
+// Bit i of the result is set when byte i of a equals byte i of b.
+uint16_t vector_cmpeq(uint8_t *a, uint8_t *b)
+{
+#ifdef __SSE2__
+    __m128i va, vb;
+
+    va = _mm_loadu_si128((__m128i *) a);
+    vb = _mm_loadu_si128((__m128i *) b);
+
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(va, vb));
+#else
+    uint16_t mask;
+
+    mask = 0;
+    for (int i = 0; i < VECTOR_SIZE; ++i) {
+        mask |= (a[i] == b[i]) << i;
+    }
+
+    return mask;
+#endif
+}
+
+// Index of the first byte equal to val, VECTOR_SIZE if there is none.
+int vector_find(uint8_t *v, uint8_t val)
+{
+#ifdef __SSE2__
+    __m128i vv;
+    int mask;
+
+    vv = _mm_loadu_si128((__m128i *) v);
+    mask = _mm_movemask_epi8(_mm_cmpeq_epi8(vv, _mm_set1_epi8(val)));
+
+    return mask == 0 ? VECTOR_SIZE : __builtin_ctz(mask);
+#else
+    for (int i = 0; i < VECTOR_SIZE; ++i) {
+        if (v[i] == val) {
+            return i;
+        }
+    }
+
+    return VECTOR_SIZE;
+#endif
+}
+
+// Packed forms treat a register as two independent bytes.
+uint16_t packed_add(uint16_t a, uint16_t b)
+{
+    return ((a & 0x7f7f) + (b & 0x7f7f)) ^ ((a ^ b) & 0x8080);
+}
+
+uint16_t packed_cmpeq(uint16_t a, uint16_t b)
+{
+    uint16_t t;
+
+    t = a ^ b;
+
+    return ((t & 0x00ff) ? 0 : 0x00ff) | ((t & 0xff00) ? 0 : 0xff00);
+}
+
+uint16_t packed_min(uint16_t a, uint16_t b)
+{
+    uint16_t lo, hi;
+
+    lo = (a & 0x00ff) < (b & 0x00ff) ? a & 0x00ff : b & 0x00ff;
+    hi = (a & 0xff00) < (b & 0xff00) ? a & 0xff00 : b & 0xff00;
+
+    return hi | lo;
+}
+
+uint16_t packed_max(uint16_t a, uint16_t b)
+{
+    uint16_t lo, hi;
+
+    lo = (a & 0x00ff) > (b & 0x00ff) ? a & 0x00ff : b & 0x00ff;
+    hi = (a & 0xff00) > (b & 0xff00) ? a & 0xff00 : b & 0xff00;
+
+    return hi | lo;
+}
+
+uint32_t load_le32(const uint8_t *p)
+{
+    return (uint32_t) p[0] | (uint32_t) p[1] << 8 | (uint32_t) p[2] << 16 | (uint32_t) p[3] << 24;
+}
+
+// CRC32C (Castagnoli, reflected). Without SSE4.2 it runs slicing-by-8 over
+// eight 256-entry tables, built on first use.
+uint32_t crc32c_table[8][256];
+pthread_once_t crc32c_once = PTHREAD_ONCE_INIT;
+
+void crc32c_init(void)
+{
+    uint32_t c;
+    int i, j;
+
+    for (i = 0; i < 256; ++i) {
+        c = i;
+        for (j = 0; j < 8; ++j) {
+            c = (c >> 1) ^ (c & 1 ? 0x82f63b78 : 0);
+        }
+        crc32c_table[0][i] = c;
+    }
+
+    for (i = 0; i < 256; ++i) {
+        c = crc32c_table[0][i];
+        for (j = 1; j < 8; ++j) {
+            c = (c >> 8) ^ crc32c_table[0][c & 0xff];
+            crc32c_table[j][i] = c;
+        }
+    }
+}
+
+uint32_t crc32c_slice8(uint32_t crc, const uint8_t *p, int len)
+{
+    uint32_t (*t)[256];
+    uint32_t lo, hi;
+
+    pthread_once(&crc32c_once, crc32c_init);
+
+    t = crc32c_table;
+
+    for (; len >= 8; p += 8, len -= 8) {
+        lo = crc ^ load_le32(p);
+        hi = load_le32(p + 4);
+        crc = t[7][lo & 0xff] ^ t[6][(lo >> 8) & 0xff]
+            ^ t[5][(lo >> 16) & 0xff] ^ t[4][lo >> 24]
+            ^ t[3][hi & 0xff] ^ t[2][(hi >> 8) & 0xff]
+            ^ t[1][(hi >> 16) & 0xff] ^ t[0][hi >> 24];
+    }
+
+    for (; len > 0; --len) {
+        crc = (crc >> 8) ^ t[0][(crc ^ *p++) & 0xff];
+    }
+
+    return crc;
+}
+
+#ifdef __x86_64__
+// Built for SSE4.2 regardless of the compiler flags; crc32c_update only
+// calls it after checking the cpu.
+__attribute__((target("sse4.2")))
+uint32_t crc32c_hw(uint32_t crc, const uint8_t *p, int len)
+{
+    uint64_t c, w;
+
+    c = crc;
+    for (; len >= 8; p += 8, len -= 8) {
+        memcpy(&w, p, 8);
+        c = _mm_crc32_u64(c, w);
+    }
+
+    crc = c;
+    for (; len > 0; --len) {
+        crc = _mm_crc32_u8(crc, *p++);
+    }
+
+    return crc;
+}
+#endif
+
+// crc is a previous result, or 0 to start a new checksum.
+uint32_t crc32c_update(uint32_t crc, const uint8_t *p, int len)
+{
+#ifdef __x86_64__
+    if (__builtin_cpu_supports("sse4.2")) {
+        return ~crc32c_hw(~crc, p, len);
+    }
+#endif
+
+    return ~crc32c_slice8(~crc, p, len);
+}
+
+#define XXH_PRIME1 2654435761u
+#define XXH_PRIME2 2246822519u
+#define XXH_PRIME3 3266489917u
+#define XXH_PRIME4 668265263u
+#define XXH_PRIME5 374761393u
+
+uint32_t rotl32(uint32_t x, int r)
+{
+    return (x << r) | (x >> (32 - r));
+}
+
+uint32_t xxh32_round(uint32_t acc, uint32_t input)
+{
+    return rotl32(acc + input * XXH_PRIME2, 13) * XXH_PRIME1;
+}
+
+// xxHash32 of the whole buffer in one go.
+uint32_t xxh32_hash(uint32_t seed, const uint8_t *p, int len)
+{
+    const uint8_t *end;
+    uint32_t v1, v2, v3, v4, h;
+
+    end = p + len;
+
+    if (len >= 16) {
+        v1 = seed + XXH_PRIME1 + XXH_PRIME2;
+        v2 = seed + XXH_PRIME2;
+        v3 = seed;
+        v4 = seed - XXH_PRIME1;
+
+        for (; end - p >= 16; p += 16) {
+            v1 = xxh32_round(v1, load_le32(p));
+            v2 = xxh32_round(v2, load_le32(p + 4));
+            v3 = xxh32_round(v3, load_le32(p + 8));
+            v4 = xxh32_round(v4, load_le32(p + 12));
+        }
+
+        h = rotl32(v1, 1) + rotl32(v2, 7) + rotl32(v3, 12) + rotl32(v4, 18);
+    } else {
+        h = seed + XXH_PRIME5;
+    }
+
+    h += len;
+
+    for (; end - p >= 4; p += 4) {
+        h = rotl32(h + load_le32(p) * XXH_PRIME3, 17) * XXH_PRIME4;
+    }
+
+    for (; p < end; ++p) {
+        h = rotl32(h + *p * XXH_PRIME5, 11) * XXH_PRIME1;
+    }
+
+    h ^= h >> 15;
+    h *= XXH_PRIME2;
+    h ^= h >> 13;
+    h *= XXH_PRIME3;
+    h ^= h >> 16;
+
+    return h;
+}
+
+enum operand_layout {
+    OPERANDS_NONE,
+    OPERANDS_REG4_REG4,
+    OPERANDS_IMM16_REG8,
+    OPERANDS_IMM8_REG8,
+    OPERANDS_REG8_IMM16,
+    OPERANDS_REG8,
+    OPERANDS_IMM16,
+    OPERANDS_REG4_REG4_REG8,
+    OPERANDS_REG4_REG4_REG4_REG4,
+    OPERANDS_REG4_REG4_SCALE_REG4,
+    OPERANDS_REG4_REG4_IMM16,
+    OPERANDS_IMM8,
+    OPERANDS_COND_REG4_REG4,
+    OPERANDS_COND_REG8,
+    OPERANDS_REG8_IMM8
+};
+
+enum operand_layout opcode_layout[VM_OPCODE_COUNT] = {
+#define X(name, layout, flow) [name] = OPERANDS_##layout,
+    VM_OPCODES(X)
+#undef X
+};
+
+const char *opcode_name[VM_OPCODE_COUNT] = {
+#define X(name, layout, flow) [name] = #name,
+    VM_OPCODES(X)
+#undef X
+};
+
+int operand_size[] = {
+    [OPERANDS_NONE] = 0,
+    [OPERANDS_REG4_REG4] = 1,
+    [OPERANDS_IMM16_REG8] = 3,
+    [OPERANDS_IMM8_REG8] = 2,
+    [OPERANDS_REG8_IMM16] = 3,
+    [OPERANDS_REG8] = 1,
+    [OPERANDS_IMM16] = 2,
+    [OPERANDS_REG4_REG4_REG8] = 2,
+    [OPERANDS_REG4_REG4_REG4_REG4] = 2,
+    [OPERANDS_REG4_REG4_SCALE_REG4] = 2,
+    [OPERANDS_REG4_REG4_IMM16] = 3,
+    [OPERANDS_IMM8] = 1,
+    [OPERANDS_COND_REG4_REG4] = 2,
+    [OPERANDS_COND_REG8] = 2,
+    [OPERANDS_REG8_IMM8] = 2
+};
+
+// Offset of the whole byte register operand from the opcode, 0 if none.
+int reg8_offset[] = {
+    [OPERANDS_NONE] = 0,
+    [OPERANDS_REG4_REG4] = 0,
+    [OPERANDS_IMM16_REG8] = 3,
+    [OPERANDS_IMM8_REG8] = 2,
+    [OPERANDS_REG8_IMM16] = 1,
+    [OPERANDS_REG8] = 1,
+    [OPERANDS_IMM16] = 0,
+    [OPERANDS_REG4_REG4_REG8] = 2,
+    [OPERANDS_REG4_REG4_REG4_REG4] = 0,
+    [OPERANDS_REG4_REG4_SCALE_REG4] = 0,
+    [OPERANDS_REG4_REG4_IMM16] = 0,
+    [OPERANDS_IMM8] = 0,
+    [OPERANDS_COND_REG4_REG4] = 0,
+    [OPERANDS_COND_REG8] = 2,
+    [OPERANDS_REG8_IMM8] = 1
+};
+
+// Offset of the immediate or condition operand from the opcode, 0 if none.
+int imm_offset[] = {
+    [OPERANDS_NONE] = 0,
+    [OPERANDS_REG4_REG4] = 0,
+    [OPERANDS_IMM16_REG8] = 1,
+    [OPERANDS_IMM8_REG8] = 1,
+    [OPERANDS_REG8_IMM16] = 2,
+    [OPERANDS_REG8] = 0,
+    [OPERANDS_IMM16] = 1,
+    [OPERANDS_REG4_REG4_REG8] = 0,
+    [OPERANDS_REG4_REG4_REG4_REG4] = 0,
+    [OPERANDS_REG4_REG4_SCALE_REG4] = 0,
+    [OPERANDS_REG4_REG4_IMM16] = 2,
+    [OPERANDS_IMM8] = 1,
+    [OPERANDS_COND_REG4_REG4] = 1,
+    [OPERANDS_COND_REG8] = 1,
+    [OPERANDS_REG8_IMM8] = 2
+};
+
+enum operand_kind {
+    OPERAND_NONE,
+    OPERAND_REG4,
+    OPERAND_REG8,
+    OPERAND_IMM8,
+    OPERAND_IMM16,
+    OPERAND_COND,
+    // A multiplier from 0 to 15 in a nibble of its own.
+    OPERAND_SCALE
+};
+
+// The operands of each layout in encoding order. Consecutive nibble
+// operands (REG4 and SCALE) share a byte, first one in the high nibble.
+enum operand_kind operand_kinds[][4] = {
+    [OPERANDS_NONE] = {OPERAND_NONE},
+    [OPERANDS_REG4_REG4] = {OPERAND_REG4, OPERAND_REG4},
+    [OPERANDS_IMM16_REG8] = {OPERAND_IMM16, OPERAND_REG8},
+    [OPERANDS_IMM8_REG8] = {OPERAND_IMM8, OPERAND_REG8},
+    [OPERANDS_REG8_IMM16] = {OPERAND_REG8, OPERAND_IMM16},
+    [OPERANDS_REG8] = {OPERAND_REG8},
+    [OPERANDS_IMM16] = {OPERAND_IMM16},
+    [OPERANDS_REG4_REG4_REG8] = {OPERAND_REG4, OPERAND_REG4, OPERAND_REG8},
+    [OPERANDS_REG4_REG4_REG4_REG4] = {OPERAND_REG4, OPERAND_REG4, OPERAND_REG4, OPERAND_REG4},
+    [OPERANDS_REG4_REG4_SCALE_REG4] = {OPERAND_REG4, OPERAND_REG4, OPERAND_SCALE, OPERAND_REG4},
+    [OPERANDS_REG4_REG4_IMM16] = {OPERAND_REG4, OPERAND_REG4, OPERAND_IMM16},
+    [OPERANDS_IMM8] = {OPERAND_IMM8},
+    [OPERANDS_COND_REG4_REG4] = {OPERAND_COND, OPERAND_REG4, OPERAND_REG4},
+    [OPERANDS_COND_REG8] = {OPERAND_COND, OPERAND_REG8},
+    [OPERANDS_REG8_IMM8] = {OPERAND_REG8, OPERAND_IMM8}
+};
+
+const char *register_name[VM_REGISTER_COUNT] = {
+    "R0", "R1", "R2", "R3", "R4", "R5", "R6", "R7",
+    "R8", "R9", "R10", "R11", "R12", "R13", "RSP", "RBP"
+};
+
+const char *condition_name[VM_CONDITION_COUNT] = {
+    "E", "NE", "G", "GE", "L", "LE", "A", "AE", "B", "BE"
+};
+
+int operand_count(enum vm_opcode op)
+{
+    int n;
+
+    for (n = 0; n < 4 && operand_kinds[opcode_layout[op]][n] != OPERAND_NONE; ++n) {
+    }
+
+    return n;
+}
+
+int instruction_size(struct vm *vm, enum vm_opcode op)
+{
+    return vm->encoding == ENCODING_FIXED ? 4 : 1 + operand_size[opcode_layout[op]];
+}
+
+// Writes op with its operands, given in encoding order, at addr in the
+// current encoding and returns the size of the instruction.
+int encode_instruction(struct vm *vm, uint16_t addr, enum vm_opcode op, const uint16_t *operands)
+{
+    enum operand_kind *kinds;
+    int n, size;
+
+    kinds = operand_kinds[opcode_layout[op]];
+    n = operand_count(op);
+
+    write_byte(vm, op, addr);
+
+    if (vm->encoding == ENCODING_FIXED) {
+        uint16_t nibbles, imm;
+        int shift;
+
+        nibbles = 0;
+        imm = 0;
+        shift = 12;
+        for (int i = 0; i < n; ++i) {
+            if (kinds[i] == OPERAND_REG4 || kinds[i] == OPERAND_REG8 || kinds[i] == OPERAND_SCALE) {
+                nibbles |= (operands[i] & 0x0f) << shift;
+                shift -= 4;
+            } else {
+                imm = operands[i];
+            }
+        }
+
+        write_byte(vm, nibbles >> 8, addr + 1);
+        write_word(vm, imm | (nibbles & 0xff), addr + 2);
+
+        return 4;
+    }
+
+    size = 1;
+    for (int i = 0; i < n; ++i) {
+        switch (kinds[i]) {
+        case OPERAND_REG4:
+        case OPERAND_SCALE:
+            write_byte(vm, (operands[i] << 4) | (operands[i + 1] & 0x0f), addr + size++);
+            ++i;
+            break;
+        case OPERAND_IMM16:
+            write_word(vm, operands[i], addr + size);
+            size += 2;
+            break;
+        default:
+            write_byte(vm, operands[i], addr + size++);
+            break;
+        }
+    }
+
+    return size;
+}
+
+// The reverse of encode_instruction for the instruction at addr. Returns
+// its size, or 0 if the opcode is unknown.
+int decode_operands(struct vm *vm, uint16_t addr, uint16_t *operands)
+{
+    enum operand_kind *kinds;
+    uint8_t op;
+    int n, size;
+
+    op = read_byte(vm, addr);
+    if (op >= VM_OPCODE_COUNT) {
+        return 0;
+    }
+
+    kinds = operand_kinds[opcode_layout[op]];
+    n = operand_count(op);
+
+    if (vm->encoding == ENCODING_FIXED) {
+        uint16_t nibbles, imm;
+        int shift;
+
+        imm = read_word(vm, addr + 2);
+        nibbles = (read_byte(vm, addr + 1) << 8) | (imm & 0xff);
+        shift = 12;
+        for (int i = 0; i < n; ++i) {
+            if (kinds[i] == OPERAND_REG4 || kinds[i] == OPERAND_REG8 || kinds[i] == OPERAND_SCALE) {
+                operands[i] = (nibbles >> shift) & 0x0f;
+                shift -= 4;
+            } else {
+                operands[i] = kinds[i] == OPERAND_IMM8 ? imm & 0xff : imm;
+            }
+        }
+
+        return 4;
+    }
+
+    size = 1;
+    for (int i = 0; i < n; ++i) {
+        switch (kinds[i]) {
+        case OPERAND_REG4:
+        case OPERAND_SCALE:
+            operands[i] = read_byte(vm, addr + size) >> 4;
+            operands[i + 1] = read_byte(vm, addr + size++) & 0x0f;
+            ++i;
+            break;
+        case OPERAND_IMM16:
+            operands[i] = read_word(vm, addr + size);
+            size += 2;
+            break;
+        default:
+            operands[i] = read_byte(vm, addr + size++);
+            break;
+        }
+    }
+
+    return size;
+}
+
+// Formats the instruction at addr as text, for example `MOVI 0x0005, R10`,
+// and returns its size. Unknown opcodes come out as a `.byte` line of size
+// 1.
+int disassemble(struct vm *vm, uint16_t addr, char *buf, int len)
+{
+    uint16_t operands[4];
+    enum operand_kind *kinds;
+    uint8_t op;
+    int n, size, used;
+
+    op = read_byte(vm, addr);
+    size = decode_operands(vm, addr, operands);
+    if (size == 0) {
+        snprintf(buf, len, ".byte 0x%02x", op);
+        return 1;
+    }
+
+    kinds = operand_kinds[opcode_layout[op]];
+    n = operand_count(op);
+
+    used = snprintf(buf, len, "%s", opcode_name[op]);
+    for (int i = 0; i < n && used < len; ++i) {
+        const char *sep;
+        uint16_t v;
+
+        sep = i == 0 ? " " : ", ";
+        v = operands[i];
+
+        switch (kinds[i]) {
+        case OPERAND_REG4:
+        case OPERAND_REG8:
+            if (v < VM_REGISTER_COUNT) {
+                used += snprintf(buf + used, len - used, "%s%s", sep, register_name[v]);
+            } else {
+                used += snprintf(buf + used, len - used, "%s?0x%02x", sep, v);
+            }
+            break;
+        case OPERAND_COND:
+            if (v < VM_CONDITION_COUNT) {
+                used += snprintf(buf + used, len - used, "%s%s", sep, condition_name[v]);
+            } else {
+                used += snprintf(buf + used, len - used, "%s?0x%02x", sep, v);
+            }
+            break;
+        case OPERAND_IMM8:
+            used += snprintf(buf + used, len - used, "%s0x%02x", sep, v);
+            break;
+        case OPERAND_SCALE:
+            used += snprintf(buf + used, len - used, "%s%d", sep, v);
+            break;
+        default:
+            used += snprintf(buf + used, len - used, "%s0x%04x", sep, v);
+            break;
+        }
+    }
+
+    return size;
+}
+
+// Where execution goes after an instruction, the third column of
+// VM_OPCODES. Jumps, branches and calls take their target from the
+// immediate: an address, or with _REL a signed distance from the end of
+// the instruction. Branches and loops may also fall through, calls come
+// back to the next instruction. JTAB takes its targets from a jump table,
+// and END instructions go nowhere the verifier can see.
+enum flow_class {
+    FLOW_NEXT,
+    FLOW_END,
+    FLOW_JUMP,
+    FLOW_JUMP_REL,
+    FLOW_BRANCH,
+    FLOW_BRANCH_REL,
+    FLOW_CALL,
+    FLOW_CALL_REL,
+    FLOW_LOOP,
+    FLOW_TABLE
+};
+
+enum flow_class opcode_flow[VM_OPCODE_COUNT] = {
+#define X(name, layout, flow) [name] = FLOW_##flow,
+    VM_OPCODES(X)
+#undef X
+};
+
+int flow_falls_through[] = {
+    [FLOW_NEXT] = 1,
+    [FLOW_END] = 0,
+    [FLOW_JUMP] = 0,
+    [FLOW_JUMP_REL] = 0,
+    [FLOW_BRANCH] = 1,
+    [FLOW_BRANCH_REL] = 1,
+    [FLOW_CALL] = 1,
+    [FLOW_CALL_REL] = 1,
+    [FLOW_LOOP] = 1,
+    [FLOW_TABLE] = 0
+};
+
+enum flow_target {
+    TARGET_NONE,
+    TARGET_ABSOLUTE,
+    TARGET_RELATIVE,
+    TARGET_TABLE
+};
+
+enum flow_target flow_target[] = {
+    [FLOW_NEXT] = TARGET_NONE,
+    [FLOW_END] = TARGET_NONE,
+    [FLOW_JUMP] = TARGET_ABSOLUTE,
+    [FLOW_JUMP_REL] = TARGET_RELATIVE,
+    [FLOW_BRANCH] = TARGET_ABSOLUTE,
+    [FLOW_BRANCH_REL] = TARGET_RELATIVE,
+    [FLOW_CALL] = TARGET_ABSOLUTE,
+    [FLOW_CALL_REL] = TARGET_RELATIVE,
+    [FLOW_LOOP] = TARGET_RELATIVE,
+    [FLOW_TABLE] = TARGET_TABLE
+};
+
+// Target of a relative jump whose distance is at imm, as wide as the
+// immediate operand of layout.
+int relative_target(struct vm *vm, enum operand_layout layout, int imm, int next)
+{
+    for (int i = 0; i < 4; ++i) {
+        if (operand_kinds[layout][i] == OPERAND_IMM8) {
+            return next + (int8_t) read_byte(vm, imm);
+        }
+    }
+
+    return next + (int16_t) read_word(vm, imm);
+}
+
+enum code_mark {
+    CODE_NONE,
+    CODE_START,
+    CODE_OPERAND
+};
+
+void code_mark(struct vm *vm, int addr, enum code_mark mark)
+{
+    vm->code_map[addr] = mark;
+
+    if (addr < vm->code_lo) {
+        vm->code_lo = addr;
+    }
+    if (addr >= vm->code_hi) {
+        vm->code_hi = addr + 1;
+    }
+}
+
+// The verified dispatch trusts every instruction marked CODE_START in
+// code_map, so anything that transfers control to a computed address (RET,
+// CALLR) must land on one of them.
+int verify_target(struct vm *vm, uint16_t target, uint16_t *pending, int *npending)
+{
+    if (vm->encoding == ENCODING_FIXED && target % 4 != 0) {
+        vm_log(vm, "verify: misaligned jump to ram[%d]", target);
+        return -1;
+    }
+
+    if (vm->code_map[target] == CODE_OPERAND) {
+        vm_log(vm, "verify: jump into the middle of an instruction at ram[%d]", target);
+        return -1;
+    }
+
+    if (vm->code_map[target] == CODE_NONE) {
+        code_mark(vm, target, CODE_START);
+        pending[(*npending)++] = target;
+    }
+
+    return 0;
+}
+
+// Jump tables are a count word, a default target word and count target
+// words. Only the targets are checked; the table itself is plain data.
+int verify_table(struct vm *vm, uint16_t table, uint16_t *pending, int *npending)
+{
+    int count;
+
+    count = read_word(vm, table);
+
+    if (table + 4 + 2 * count > RAM_CAP) {
+        vm_log(vm, "verify: jump table at ram[%d] runs past the end of ram", table);
+        return -1;
+    }
+
+    if (verify_target(vm, read_word(vm, table + 2), pending, npending) != 0) {
+        return -1;
+    }
+
+    for (int i = 0; i < count; ++i) {
+        if (verify_target(vm, read_word(vm, table + 4 + 2 * i), pending, npending) != 0) {
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+// Walks every instruction reachable from entry and checks that opcodes are
+// known, register operands are in range, no instruction runs past the end
+// of ram and every jump lands on an instruction boundary. On success the
+// image runs in the unchecked dispatch mode of vm_start. The image is
+// decoded in the current encoding.
+int verify_image(struct vm *vm, uint16_t entry)
+{
+    uint16_t *pending;
+    int npending, fixed;
+
+    // Nothing is staged while an image loads, so the block buffers hold the
+    // work list: one entry per byte of ram at most.
+    pending = (uint16_t *) vm->block_buf;
+
+    // Everything around the marked range is CODE_NONE already, so the
+    // whole pages it touches can go.
+    vm->verified = 0;
+    if (vm->code_lo < vm->code_hi) {
+        anon_clear(vm->code_map, vm->code_lo, vm->code_hi);
+    }
+    vm->code_lo = RAM_CAP;
+    vm->code_hi = 0;
+
+    fixed = vm->encoding == ENCODING_FIXED;
+    if (fixed && entry % 4 != 0) {
+        vm_log(vm, "verify: misaligned entry point ram[%d]", entry);
+        return -1;
+    }
+
+    npending = 0;
+    code_mark(vm, entry, CODE_START);
+    pending[npending++] = entry;
+
+    while (npending > 0) {
+        int addr, size, next, imm;
+        uint8_t opcode;
+        enum operand_layout layout;
+        enum flow_class flow;
+
+        addr = pending[--npending];
+        opcode = read_byte(vm, addr);
+
+        if (opcode >= VM_OPCODE_COUNT) {
+            vm_log(vm, "verify: unknown opcode `%02x` at ram[%d]", opcode, addr);
+            return -1;
+        }
+
+        layout = opcode_layout[opcode];
+        size = instruction_size(vm, opcode);
+        next = addr + size;
+        imm = fixed ? addr + 2 : addr + imm_offset[layout];
+
+        if (next > RAM_CAP) {
+            vm_log(vm, "verify: instruction at ram[%d] runs past the end of ram", addr);
+            return -1;
+        }
+
+        for (int i = addr + 1; i < next; ++i) {
+            if (vm->code_map[i] != CODE_NONE) {
+                vm_log(vm, "verify: instructions overlap at ram[%d]", i);
+                return -1;
+            }
+            code_mark(vm, i, CODE_OPERAND);
+        }
+
+        if (!fixed && reg8_offset[layout] != 0) {
+            uint8_t r;
+
+            r = read_byte(vm, addr + reg8_offset[layout]);
+            if (r >= VM_REGISTER_COUNT) {
+                vm_log(vm, "verify: invalid register `%02x` at ram[%d]", r, addr);
+                return -1;
+            }
+        }
+
+        if (layout == OPERANDS_COND_REG4_REG4 || layout == OPERANDS_COND_REG8) {
+            int c;
+
+            c = fixed ? read_word(vm, imm) : read_byte(vm, imm);
+            if (c >= VM_CONDITION_COUNT) {
+                vm_log(vm, "verify: invalid condition `%02x` at ram[%d]", c, addr);
+                return -1;
+            }
+        }
+
+        flow = opcode_flow[opcode];
+
+        switch (flow_target[flow]) {
+        case TARGET_ABSOLUTE:
+            if (verify_target(vm, read_word(vm, imm), pending, &npending) != 0) {
+                return -1;
+            }
+            break;
+        case TARGET_RELATIVE:
+            if (verify_target(vm, relative_target(vm, layout, imm, next), pending, &npending) != 0) {
+                return -1;
+            }
+            break;
+        case TARGET_TABLE:
+            if (verify_table(vm, read_word(vm, imm), pending, &npending) != 0) {
+                return -1;
+            }
+            break;
+        default:
+            break;
+        }
+
+        if (flow_falls_through[flow]) {
+            if (next == RAM_CAP) {
+                vm_log(vm, "verify: execution runs off the end of ram at ram[%d]", addr);
+                return -1;
+            }
+
+            if (verify_target(vm, next, pending, &npending) != 0) {
+                return -1;
+            }
+        }
+    }
+
+    vm->verified = 1;
+
+    return 0;
+}
+
+// What vm_exec returns besides an enum vm_status: the unchecked dispatch
+// left verified code and execution has to go on in checked mode, or the
+// checked one got back to it. vm_event returns EXEC_CONTINUE when execution
+// goes on.
+enum {
+    EXEC_UNVERIFIED = -1,
+    EXEC_CONTINUE = -2,
+    EXEC_VERIFIED = -3
+};
+
+int fault(struct vm *vm, int at)
+{
+    vm->exit_pc = at;
+    return VM_FAULT;
+}
+
+uint16_t flags_pack(struct vm *vm)
+{
+    uint16_t word;
+
+    word = 0;
+    for (int i = 0; i < VM_FLAG_COUNT; ++i) {
+        word |= (vm->flags[i] != 0) << i;
+    }
+
+    return word;
+}
+
+void flags_unpack(struct vm *vm, uint16_t word)
+{
+    for (int i = 0; i < VM_FLAG_COUNT; ++i) {
+        vm->flags[i] = (word >> i) & 1;
+    }
+}
+
+void interrupt_take(struct vm *vm, int n)
+{
+    vm->interrupts &= ~(1 << n);
+
+    stack_push(vm, vm->pc);
+    stack_push(vm, flags_pack(vm));
+    vm->flags[IF] = 0;
+    vm->pc = read_word(vm, INTERRUPT_VECTORS + 2 * n);
+}
+
+// Called by vm_exec when the countdown runs out. Fires the timer, stops at
+// the end of the budget and otherwise takes the lowest pending interrupt
+// if interrupts are enabled.
+int vm_event(struct vm *vm)
+{
+    clock_sync(vm);
+
+    if (vm->timer != NULL && vm->timer->left == 0 && vm->timer->reload != 0) {
+        vm->interrupts |= 1 << INTERRUPT_TIMER;
+        vm->timer->left = vm->timer->reload;
+    }
+
+    if (vm->budget == 0) {
+        return VM_BUDGET;
+    }
+
+    if (vm->interrupts != 0 && vm->flags[IF]) {
+        interrupt_take(vm, __builtin_ctz(vm->interrupts));
+    }
+
+    clock_schedule(vm);
+
+    return EXEC_CONTINUE;
+}
+
+// Operand fetches for both encodings. Variable encoded operands are read
+// from the bytes after the opcode as they are needed. A fixed instruction
+// was loaded whole before dispatch: its registers are taken in order from
+// the nibbles of the second byte and then of the low immediate byte,
+// immediates and conditions from the imm16 field.
+#define fetch_registers(r1, r2) \
+    do { \
+        if (fixed) { \
+            (r1) = (fixed_nibbles >> 12) & 0x0f; \
+            (r2) = (fixed_nibbles >> 8) & 0x0f; \
+            fixed_nibbles <<= 8; \
+        } else { \
+            decode_registers(read_byte(vm, vm->pc++), &(r1), &(r2)); \
+        } \
+    } while (0)
+
+// Register operands encoded in a whole byte are range checked unless the
+// image was verified. The mask keeps the unchecked path inside regfile even
+// if a verified image overwrites its own code.
+#define fetch_register(r) \
+    do { \
+        if (fixed) { \
+            (r) = (fixed_nibbles >> 12) & 0x0f; \
+            fixed_nibbles <<= 4; \
+            break; \
+        } \
+        (r) = read_byte(vm, vm->pc++); \
+        if (checked && (r) >= VM_REGISTER_COUNT) { \
+            vm_log(vm, "invalid register `%02x` at ram[%d]", (r), saved_pc); \
+            return fault(vm, saved_pc); \
+        } \
+        (r) &= 0x0f; \
+    } while (0)
+
+// Unchecked, an out of range condition is harmless: condition() treats it
+// as BE.
+#define fetch_condition(c) \
+    do { \
+        (c) = fixed ? fixed_imm : read_byte(vm, vm->pc++); \
+        if (checked && (c) >= VM_CONDITION_COUNT) { \
+            vm_log(vm, "invalid condition `%02x` at ram[%d]", (c), saved_pc); \
+            return fault(vm, saved_pc); \
+        } \
+    } while (0)
+
+#define fetch_imm16(v) \
+    do { \
+        if (fixed) { \
+            (v) = fixed_imm; \
+        } else { \
+            (v) = read_word(vm, vm->pc++); vm->pc++; \
+        } \
+    } while (0)
+
+#define fetch_imm8(v) \
+    do { \
+        if (fixed) { \
+            (v) = fixed_imm; \
+        } else { \
+            (v) = read_byte(vm, vm->pc++); \
+        } \
+    } while (0)
+
+// Returns why execution stopped, an enum vm_status, EXEC_UNVERIFIED or
+// EXEC_VERIFIED.
+// Always inlined so that each call site in vm_execute gets its own copy
+// with the checks folded away. Only runs with a budget or a timer count
+// instructions, and both share the one countdown.
+static inline __attribute__((always_inline)) int vm_exec(struct vm *vm, int checked, int fixed, int counted)
+{
+    for (;;) {
+        uint8_t opcode;
+        int saved_pc;
+        uint16_t fixed_nibbles, fixed_imm;
+
+        if (counted) {
+            if (vm->countdown == 0) {
+                int status;
+
+                status = vm_event(vm);
+                if (status != EXEC_CONTINUE) {
+                    return status;
+                }
+                if (!checked && vm->code_map[(uint16_t) vm->pc] != CODE_START) {
+                    return EXEC_UNVERIFIED;
+                }
+                // Back from an interrupt handler outside the verified code,
+                // or into a handler inside it.
+                if (checked && vm->verified && vm->code_map[(uint16_t) vm->pc] == CODE_START) {
+                    return EXEC_VERIFIED;
+                }
+            }
+            vm->countdown--;
+        }
+
+        saved_pc = vm->pc;
+
+        if (fixed) {
+            uint32_t word;
+
+            if (checked && vm->pc % 4 != 0) {
+                vm_log(vm, "misaligned instruction at ram[%d]", saved_pc);
+                return fault(vm, saved_pc);
+            }
+
+            word = read_instruction(vm, vm->pc);
+            opcode = word;
+            fixed_nibbles = (word & 0xff00) | ((word >> 16) & 0xff);
+            fixed_imm = word >> 16;
+            vm->pc += 4;
+        } else {
+            opcode = read_byte(vm, vm->pc++);
+        }
+
+        switch (opcode) {
+        case HALT:
+            return VM_HALTED;
+
+        case MOV: {
+            enum vm_register r1, r2;
+
+            fetch_registers(r1, r2);
+            vm->regfile[r2] = vm->regfile[r1];
+        } break;
+
+        case MOVI: {
+            uint16_t imm;
+            enum vm_register r1;
+
+            fetch_imm16(imm);
+            fetch_register(r1);
+
+            vm->regfile[r1] = imm;
+        } break;
+
+        case MOVB: {
+            enum vm_register r1, r2;
+
+            fetch_registers(r1, r2);
+            register_write_byte(vm, r2, vm->regfile[r1]);
+        } break;
+
+        case MOVBI: {
+            uint8_t imm;
+            enum vm_register r1;
+
+            fetch_imm8(imm);
+            fetch_register(r1);
+
+            register_write_byte(vm, r1, imm);
+        } break;
+
+        case MOVZE: {
+            enum vm_register r1, r2;
+
+            fetch_registers(r1, r2);
+            vm->regfile[r2] = (uint8_t) vm->regfile[r1];
+        } break;
+
+        case MOVSE: {
+            enum vm_register r1, r2;
+
+            fetch_registers(r1, r2);
+            vm->regfile[r2] = (int8_t) vm->regfile[r1];
+        } break;
+
+        case CMOV: {
+            enum vm_condition c;
+            enum vm_register r1, r2;
+
+            fetch_condition(c);
+            fetch_registers(r1, r2);
+            vm->regfile[r2] = condition(vm, c) ? vm->regfile[r1] : vm->regfile[r2];
+        } break;
+
+        case SET: {
+            enum vm_condition c;
+            enum vm_register r1;
+
+            fetch_condition(c);
+            fetch_register(r1);
+            vm->regfile[r1] = condition(vm, c);
+        } break;
+
+        case ST: {
+            enum vm_register r1, r2;
+
+            fetch_registers(r1, r2);
+            store_word(vm, vm->regfile[r1], vm->regfile[r2]);
+        } break;
+
+        case STI: {
+            enum vm_register r1;
+            uint16_t imm;
+
+            fetch_register(r1);
+            fetch_imm16(imm);
+            store_word(vm, vm->regfile[r1], imm);
+        } break;
+
+        case STB: {
+            enum vm_register r1, r2;
+
+            fetch_registers(r1, r2);
+            store_byte(vm, vm->regfile[r1], vm->regfile[r2]);
+        } break;
+
+        case STBI: {
+            enum vm_register r1;
+            uint16_t imm;
+
+            fetch_register(r1);
+            fetch_imm16(imm);
+            store_byte(vm, vm->regfile[r1], imm);
+        } break;
+
+        case LD: {
+            enum vm_register r1, r2;
+
+            fetch_registers(r1, r2);
+            vm->regfile[r2] = load_word(vm, vm->regfile[r1]);
+        } break;
+
+        case LDI: {
+            enum vm_register r1;
+            uint16_t imm;
+
+            fetch_imm16(imm);
+            fetch_register(r1);
+            vm->regfile[r1] = load_word(vm, imm);
+        } break;
+
+        case LDB: {
+            enum vm_register r1, r2;
+
+            fetch_registers(r1, r2);
+            register_write_byte(vm, r2, load_byte(vm, vm->regfile[r1]));
+        } break;
+
+        case LDBI: {
+            enum vm_register r1;
+            uint16_t imm;
+
+            fetch_imm16(imm);
+            fetch_register(r1);
+            register_write_byte(vm, r1, load_byte(vm, imm));
+        } break;
+
+        case STD: {
+            enum vm_register r1, r2;
+            uint16_t disp;
+
+            fetch_registers(r1, r2);
+            fetch_imm16(disp);
+            store_word(vm, vm->regfile[r1], vm->regfile[r2] + disp);
+        } break;
+
+        case STBD: {
+            enum vm_register r1, r2;
+            uint16_t disp;
+
+            fetch_registers(r1, r2);
+            fetch_imm16(disp);
+            store_byte(vm, vm->regfile[r1], vm->regfile[r2] + disp);
+        } break;
+
+        case LDD: {
+            enum vm_register r1, r2;
+            uint16_t disp;
+
+            fetch_registers(r1, r2);
+            fetch_imm16(disp);
+            vm->regfile[r2] = load_word(vm, vm->regfile[r1] + disp);
+        } break;
+
+        case LDBD: {
+            enum vm_register r1, r2;
+            uint16_t disp;
+
+            fetch_registers(r1, r2);
+            fetch_imm16(disp);
+            register_write_byte(vm, r2, load_byte(vm, vm->regfile[r1] + disp));
+        } break;
+
+        // Indexed forms address base + index * scale. The scale nibble is
+        // fetched like a register but used as a number.
+        case STX: {
+            enum vm_register r1, r2, scale, r4;
+
+            fetch_registers(r1, r2);
+            fetch_registers(scale, r4);
+            store_word(vm, vm->regfile[r4], vm->regfile[r1] + vm->regfile[r2] * scale);
+        } break;
+
+        case STBX: {
+            enum vm_register r1, r2, scale, r4;
+
+            fetch_registers(r1, r2);
+            fetch_registers(scale, r4);
+            store_byte(vm, vm->regfile[r4], vm->regfile[r1] + vm->regfile[r2] * scale);
+        } break;
+
+        case LDX: {
+            enum vm_register r1, r2, scale, r4;
+
+            fetch_registers(r1, r2);
+            fetch_registers(scale, r4);
+            vm->regfile[r4] = load_word(vm, vm->regfile[r1] + vm->regfile[r2] * scale);
+        } break;
+
+        case LDBX: {
+            enum vm_register r1, r2, scale, r4;
+
+            fetch_registers(r1, r2);
+            fetch_registers(scale, r4);
+            register_write_byte(vm, r4, load_byte(vm, vm->regfile[r1] + vm->regfile[r2] * scale));
+        } break;
+
+        case BMOV: {
+            enum vm_register r1, r2, r3;
+
+            fetch_registers(r1, r2);
+            fetch_register(r3);
+
+            block_move(vm, vm->regfile[r1], vm->regfile[r2], vm->regfile[r3]);
+        } break;
+
+        case BFILL: {
+            enum vm_register r1, r2, r3;
+
+            fetch_registers(r1, r2);
+            fetch_register(r3);
+
+            block_fill(vm, vm->regfile[r1], vm->regfile[r2], vm->regfile[r3]);
+        } break;
+
+        case BCMP: {
+            enum vm_register r1, r2, r3;
+
+            fetch_registers(r1, r2);
+            fetch_register(r3);
+
+            block_compare(vm, vm->regfile[r1], vm->regfile[r2], vm->regfile[r3]);
+        } break;
+
+        case SCANB: {
+            enum vm_register r1, r2, r3, r4;
+            uint16_t len;
+
+            fetch_registers(r1, r2);
+            fetch_registers(r3, r4);
+
+            len = vm->regfile[r3];
+            vm->regfile[r4] = block_scan(vm, vm->regfile[r1], vm->regfile[r2], len);
+            vm->flags[ZF] = vm->regfile[r4] < len;
+        } break;
+
+        case MISMATCH: {
+            enum vm_register r1, r2, r3, r4;
+
+            fetch_registers(r1, r2);
+            fetch_registers(r3, r4);
+
+            vm->regfile[r4] = block_compare(vm, vm->regfile[r1], vm->regfile[r2], vm->regfile[r3]);
+        } break;
+
+        case STRNLEN: {
+            enum vm_register r1, r2, r3;
+            uint16_t limit;
+
+            fetch_registers(r1, r2);
+            fetch_register(r3);
+
+            limit = vm->regfile[r2];
+            vm->regfile[r3] = block_scan(vm, 0, vm->regfile[r1], limit);
+            vm->flags[ZF] = vm->regfile[r3] < limit;
+        } break;
+
+        case ADD: {
+            enum vm_register r1, r2;
+
+            fetch_registers(r1, r2);
+            vm->regfile[r2] = vm->regfile[r2] + vm->regfile[r1];
+        } break;
+
+        case ADDI: {
+            enum vm_register r1;
+            uint16_t imm;
+
+            fetch_imm16(imm);
+            fetch_register(r1);
+
+            vm->regfile[r1] = vm->regfile[r1] + imm;
+        } break;
+
+        case ADDB: {
+            enum vm_register r1, r2;
+
+            fetch_registers(r1, r2);
+            register_write_byte(vm, r2, vm->regfile[r2] + vm->regfile[r1]);
+        } break;
+
+        case ADDBI: {
+            enum vm_register r1;
+            uint8_t imm;
+
+            fetch_imm8(imm);
+            fetch_register(r1);
+
+            register_write_byte(vm, r1, vm->regfile[r1] + imm);
+        } break;
+
+        case SUB: {
+            enum vm_register r1, r2;
+
+            fetch_registers(r1, r2);
+            vm->regfile[r2] = vm->regfile[r2] - vm->regfile[r1];
+        } break;
+
+        case SUBI: {
+            enum vm_register r1;
+            uint16_t imm;
+
+            fetch_imm16(imm);
+            fetch_register(r1);
+
+            vm->regfile[r1] = vm->regfile[r1] - imm;
+        } break;
+
+        case SUBB: {
+            enum vm_register r1, r2;
+
+            fetch_registers(r1, r2);
+            register_write_byte(vm, r2, vm->regfile[r2] - vm->regfile[r1]);
+        } break;
+
+        case SUBBI: {
+            enum vm_register r1;
+            uint8_t imm;
+
+            fetch_imm8(imm);
+            fetch_register(r1);
+
+            register_write_byte(vm, r1, vm->regfile[r1] - imm);
+        } break;
+
+        case ADDF: {
+            enum vm_register r1, r2;
+
+            fetch_registers(r1, r2);
+
+            set_add_flags(vm, vm->regfile[r2], vm->regfile[r1], 0, 0xffff);
+            vm->regfile[r2] = vm->regfile[r2] + vm->regfile[r1];
+        } break;
+
+        case ADDFI: {
+            enum vm_register r1;
+            uint16_t imm;
+
+            fetch_imm16(imm);
+            fetch_register(r1);
+
+            set_add_flags(vm, vm->regfile[r1], imm, 0, 0xffff);
+            vm->regfile[r1] = vm->regfile[r1] + imm;
+        } break;
+
+        case ADDFB: {
+            enum vm_register r1, r2;
+
+            fetch_registers(r1, r2);
+
+            set_add_flags(vm, vm->regfile[r2], vm->regfile[r1], 0, 0xff);
+            register_write_byte(vm, r2, vm->regfile[r2] + vm->regfile[r1]);
+        } break;
+
+        case ADDFBI: {
+            enum vm_register r1;
+            uint8_t imm;
+
+            fetch_imm8(imm);
+            fetch_register(r1);
+
+            set_add_flags(vm, vm->regfile[r1], imm, 0, 0xff);
+            register_write_byte(vm, r1, vm->regfile[r1] + imm);
+        } break;
+
+        case SUBF: {
+            enum vm_register r1, r2;
+
+            fetch_registers(r1, r2);
+
+            set_sub_flags(vm, vm->regfile[r2], vm->regfile[r1], 0, 0xffff);
+            vm->regfile[r2] = vm->regfile[r2] - vm->regfile[r1];
+        } break;
+
+        case SUBFI: {
+            enum vm_register r1;
+            uint16_t imm;
+
+            fetch_imm16(imm);
+            fetch_register(r1);
+
+            set_sub_flags(vm, vm->regfile[r1], imm, 0, 0xffff);
+            vm->regfile[r1] = vm->regfile[r1] - imm;
+        } break;
+
+        case SUBFB: {
+            enum vm_register r1, r2;
+
+            fetch_registers(r1, r2);
+
+            set_sub_flags(vm, vm->regfile[r2], vm->regfile[r1], 0, 0xff);
+            register_write_byte(vm, r2, vm->regfile[r2] - vm->regfile[r1]);
+        } break;
+
+        case SUBFBI: {
+            enum vm_register r1;
+            uint8_t imm;
+
+            fetch_imm8(imm);
+            fetch_register(r1);
+
+            set_sub_flags(vm, vm->regfile[r1], imm, 0, 0xff);
+            register_write_byte(vm, r1, vm->regfile[r1] - imm);
+        } break;
+
+        case ADC: {
+            enum vm_register r1, r2;
+            int c;
+
+            fetch_registers(r1, r2);
+            c = vm->flags[CF];
+
+            set_add_flags(vm, vm->regfile[r2], vm->regfile[r1], c, 0xffff);
+            vm->regfile[r2] = vm->regfile[r2] + vm->regfile[r1] + c;
+        } break;
+
+        case ADCI: {
+            enum vm_register r1;
+            uint16_t imm;
+            int c;
+
+            fetch_imm16(imm);
+            fetch_register(r1);
+            c = vm->flags[CF];
+
+            set_add_flags(vm, vm->regfile[r1], imm, c, 0xffff);
+            vm->regfile[r1] = vm->regfile[r1] + imm + c;
+        } break;
+
+        case ADCB: {
+            enum vm_register r1, r2;
+            int c;
+
+            fetch_registers(r1, r2);
+            c = vm->flags[CF];
+
+            set_add_flags(vm, vm->regfile[r2], vm->regfile[r1], c, 0xff);
+            register_write_byte(vm, r2, vm->regfile[r2] + vm->regfile[r1] + c);
+        } break;
+
+        case ADCBI: {
+            enum vm_register r1;
+            uint8_t imm;
+            int c;
+
+            fetch_imm8(imm);
+            fetch_register(r1);
+            c = vm->flags[CF];
+
+            set_add_flags(vm, vm->regfile[r1], imm, c, 0xff);
+            register_write_byte(vm, r1, vm->regfile[r1] + imm + c);
+        } break;
+
+        case SBB: {
+            enum vm_register r1, r2;
+            int c;
+
+            fetch_registers(r1, r2);
+            c = !vm->flags[CF];
+
+            set_sub_flags(vm, vm->regfile[r2], vm->regfile[r1], c, 0xffff);
+            vm->regfile[r2] = vm->regfile[r2] - vm->regfile[r1] - c;
+        } break;
+
+        case SBBI: {
+            enum vm_register r1;
+            uint16_t imm;
+            int c;
+
+            fetch_imm16(imm);
+            fetch_register(r1);
+            c = !vm->flags[CF];
+
+            set_sub_flags(vm, vm->regfile[r1], imm, c, 0xffff);
+            vm->regfile[r1] = vm->regfile[r1] - imm - c;
+        } break;
+
+        case SBBB: {
+            enum vm_register r1, r2;
+            int c;
+
+            fetch_registers(r1, r2);
+            c = !vm->flags[CF];
+
+            set_sub_flags(vm, vm->regfile[r2], vm->regfile[r1], c, 0xff);
+            register_write_byte(vm, r2, vm->regfile[r2] - vm->regfile[r1] - c);
+        } break;
+
+        case SBBBI: {
+            enum vm_register r1;
+            uint8_t imm;
+            int c;
+
+            fetch_imm8(imm);
+            fetch_register(r1);
+            c = !vm->flags[CF];
+
+            set_sub_flags(vm, vm->regfile[r1], imm, c, 0xff);
+            register_write_byte(vm, r1, vm->regfile[r1] - imm - c);
+        } break;
+
+        case MUL: {
+            enum vm_register r1, r2;
+
+            fetch_registers(r1, r2);
+            vm->regfile[r2] = vm->regfile[r2] * vm->regfile[r1];
+        } break;
+
+        case MULI: {
+            enum vm_register r1;
+            uint16_t imm;
+
+            fetch_imm16(imm);
+            fetch_register(r1);
+
+            vm->regfile[r1] = vm->regfile[r1] * imm;
+        } break;
+
+        // The byte forms keep the whole 16-bit product, the high half ends
+        // up in the upper byte of the register.
+        case MULB: {
+            enum vm_register r1, r2;
+            uint8_t a, b;
+
+            fetch_registers(r1, r2);
+            a = vm->regfile[r2];
+            b = vm->regfile[r1];
+
+            vm->regfile[r2] = a * b;
+        } break;
+
+        case MULBI: {
+            enum vm_register r1;
+            uint8_t a, imm;
+
+            fetch_imm8(imm);
+            fetch_register(r1);
+            a = vm->regfile[r1];
+
+            vm->regfile[r1] = a * imm;
+        } break;
+
+        case MULH: {
+            enum vm_register r1, r2;
+            uint32_t t;
+
+            fetch_registers(r1, r2);
+            t = (uint32_t) vm->regfile[r2] * vm->regfile[r1];
+
+            vm->regfile[r2] = t >> 16;
+        } break;
+
+        case MULHS: {
+            enum vm_register r1, r2;
+            int16_t a, b;
+            int32_t t;
+
+            fetch_registers(r1, r2);
+            a = vm->regfile[r2];
+            b = vm->regfile[r1];
+            t = (int32_t) a * b;
+
+            vm->regfile[r2] = (uint32_t) t >> 16;
+        } break;
+
+        case DIV:
+        case MOD: {
+            enum vm_register r1, r2;
+            uint16_t a, b;
+
+            fetch_registers(r1, r2);
+            a = vm->regfile[r2];
+            b = vm->regfile[r1];
+
+            if (b == 0) {
+                vm_log(vm, "division by zero at ram[%d]", saved_pc);
+                return fault(vm, saved_pc);
+            }
+
+            vm->regfile[r2] = opcode == DIV ? a / b : a % b;
+        } break;
+
+        case DIVI:
+        case MODI: {
+            enum vm_register r1;
+            uint16_t a, imm;
+
+            fetch_imm16(imm);
+            fetch_register(r1);
+            a = vm->regfile[r1];
+
+            if (imm == 0) {
+                vm_log(vm, "division by zero at ram[%d]", saved_pc);
+                return fault(vm, saved_pc);
+            }
+
+            vm->regfile[r1] = opcode == DIVI ? a / imm : a % imm;
+        } break;
+
+        // Operands are promoted to int, so -32768 / -1 does not overflow and
+        // wraps back to -32768 when stored.
+        case DIVS:
+        case MODS: {
+            enum vm_register r1, r2;
+            int16_t a, b;
+
+            fetch_registers(r1, r2);
+            a = vm->regfile[r2];
+            b = vm->regfile[r1];
+
+            if (b == 0) {
+                vm_log(vm, "division by zero at ram[%d]", saved_pc);
+                return fault(vm, saved_pc);
+            }
+
+            vm->regfile[r2] = opcode == DIVS ? a / b : a % b;
+        } break;
+
+        case DIVSI:
+        case MODSI: {
+            enum vm_register r1;
+            int16_t a, imm;
+
+            fetch_imm16(imm);
+            fetch_register(r1);
+            a = vm->regfile[r1];
+
+            if (imm == 0) {
+                vm_log(vm, "division by zero at ram[%d]", saved_pc);
+                return fault(vm, saved_pc);
+            }
+
+            vm->regfile[r1] = opcode == DIVSI ? a / imm : a % imm;
+        } break;
+
+        case NOT: {
+            enum vm_register r1;
+
+            fetch_register(r1);
+            vm->regfile[r1] = ~vm->regfile[r1];
+        } break;
+
+        case NOTB: {
+            enum vm_register r1;
+
+            fetch_register(r1);
+            register_write_byte(vm, r1, ~vm->regfile[r1]);
+        } break;
+
+        case AND: {
+            enum vm_register r1, r2;
+
+            fetch_registers(r1, r2);
+            vm->regfile[r2] = vm->regfile[r2] & vm->regfile[r1];
+        } break;
+
+        case ANDI: {
+            enum vm_register r1;
+            uint16_t imm;
+
+            fetch_imm16(imm);
+            fetch_register(r1);
+
+            vm->regfile[r1] = vm->regfile[r1] & imm;
+        } break;
+
+        case ANDB: {
+            enum vm_register r1, r2;
+
+            fetch_registers(r1, r2);
+            register_write_byte(vm, r2, vm->regfile[r2] & vm->regfile[r1]);
+        } break;
+
+        case ANDBI: {
+            enum vm_register r1;
+            uint8_t imm;
+
+            fetch_imm8(imm);
+            fetch_register(r1);
+
+            register_write_byte(vm, r1, vm->regfile[r1] & imm);
+        } break;
+
+        case OR: {
+            enum vm_register r1, r2;
+
+            fetch_registers(r1, r2);
+            vm->regfile[r2] = vm->regfile[r2] | vm->regfile[r1];
+        } break;
+
+        case ORI: {
+            enum vm_register r1;
+            uint16_t imm;
+
+            fetch_imm16(imm);
+            fetch_register(r1);
+
+            vm->regfile[r1] = vm->regfile[r1] | imm;
+        } break;
+
+        case ORB: {
+            enum vm_register r1, r2;
+
+            fetch_registers(r1, r2);
+            register_write_byte(vm, r2, vm->regfile[r2] | vm->regfile[r1]);
+        } break;
+
+        case ORBI: {
+            enum vm_register r1;
+            uint8_t imm;
+
+            fetch_imm8(imm);
+            fetch_register(r1);
+
+            register_write_byte(vm, r1, vm->regfile[r1] | imm);
+        } break;
+
+        case XOR: {
+            enum vm_register r1, r2;
+
+            fetch_registers(r1, r2);
+            vm->regfile[r2] = vm->regfile[r2] ^ vm->regfile[r1];
+        } break;
+
+        case XORI: {
+            enum vm_register r1;
+            uint16_t imm;
+
+            fetch_imm16(imm);
+            fetch_register(r1);
+
+            vm->regfile[r1] = vm->regfile[r1] ^ imm;
+        } break;
+
+        case XORB: {
+            enum vm_register r1, r2;
+
+            fetch_registers(r1, r2);
+            register_write_byte(vm, r2, vm->regfile[r2] ^ vm->regfile[r1]);
+        } break;
+
+        case XORBI: {
+            enum vm_register r1;
+            uint8_t imm;
+
+            fetch_imm8(imm);
+            fetch_register(r1);
+
+            register_write_byte(vm, r1, vm->regfile[r1] ^ imm);
+        } break;
+
+        case SHL: {
+            enum vm_register r1, r2;
+
+            fetch_registers(r1, r2);
+            vm->regfile[r2] = vm->regfile[r2] << vm->regfile[r1];
+        } break;
+
+        case SHLI: {
+            enum vm_register r1;
+            uint8_t imm;
+
+            fetch_imm8(imm);
+            fetch_register(r1);
+
+            vm->regfile[r1] = vm->regfile[r1] << imm;
+        } break;
+
+        case SHLB: {
+            enum vm_register r1, r2;
+            uint8_t a;
+
+            fetch_registers(r1, r2);
+            a = vm->regfile[r1];
+
+            register_write_byte(vm, r2, vm->regfile[r2] << a);
+        } break;
+
+        case SHLBI: {
+            enum vm_register r1;
+            uint8_t imm;
+
+            fetch_imm8(imm);
+            fetch_register(r1);
+
+            register_write_byte(vm, r1, vm->regfile[r1] << imm);
+        } break;
+
+        case SHR: {
+            enum vm_register r1, r2;
+
+            fetch_registers(r1, r2);
+            vm->regfile[r2] = vm->regfile[r2] >> vm->regfile[r1];
+        } break;
+
+        case SHRI: {
+            enum vm_register r1;
+            uint8_t imm;
+
+            fetch_imm8(imm);
+            fetch_register(r1);
+
+            vm->regfile[r1] = vm->regfile[r1] >> imm;
+        } break;
+
+        case SHRB: {
+            enum vm_register r1, r2;
+            uint8_t a, b;
+
+            fetch_registers(r1, r2);
+            a = vm->regfile[r2];
+            b = vm->regfile[r1];
+
+            register_write_byte(vm, r2, a >> b);
+        } break;
+
+        case SHRBI: {
+            enum vm_register r1;
+            uint8_t a, imm;
+
+            fetch_imm8(imm);
+            fetch_register(r1);
+            a = vm->regfile[r1];
+
+            register_write_byte(vm, r1, a >> imm);
+        } break;
+
+        case SHRA: {
+            enum vm_register r1, r2;
+            int16_t a, b;
+
+            fetch_registers(r1, r2);
+            a = vm->regfile[r2];
+            b = vm->regfile[r1];
+
+            vm->regfile[r2] = a >> b;
+        } break;
+
+        case SHRAI: {
+            enum vm_register r1;
+            int16_t a;
+            int8_t imm;
+
+            fetch_imm8(imm);
+            fetch_register(r1);
+            a = vm->regfile[r1];
+
+            vm->regfile[r1] = a >> imm;
+        } break;
+
+        case SHRAB: {
+            enum vm_register r1, r2;
+            int8_t a, b;
+
+            fetch_registers(r1, r2);
+            a = vm->regfile[r2];
+            b = vm->regfile[r1];
+
+            register_write_byte(vm, r2, a >> b);
+        } break;
+
+        case SHRABI: {
+            enum vm_register r1;
+            int8_t a, imm;
+
+            fetch_imm8(imm);
+            fetch_register(r1);
+            a = vm->regfile[r1];
+
+            register_write_byte(vm, r1, a >> imm);
+        } break;
+
+        case PADDB: {
+            enum vm_register r1, r2;
+
+            fetch_registers(r1, r2);
+            vm->regfile[r2] = packed_add(vm->regfile[r2], vm->regfile[r1]);
+        } break;
+
+        case PCMPEQB: {
+            enum vm_register r1, r2;
+
+            fetch_registers(r1, r2);
+            vm->regfile[r2] = packed_cmpeq(vm->regfile[r2], vm->regfile[r1]);
+        } break;
+
+        case PMINUB: {
+            enum vm_register r1, r2;
+
+            fetch_registers(r1, r2);
+            vm->regfile[r2] = packed_min(vm->regfile[r2], vm->regfile[r1]);
+        } break;
+
+        case PMAXUB: {
+            enum vm_register r1, r2;
+
+            fetch_registers(r1, r2);
+            vm->regfile[r2] = packed_max(vm->regfile[r2], vm->regfile[r1]);
+        } break;
+
+        case VADDB:
+        case VMINUB:
+        case VMAXUB: {
+            enum vm_register r1, r2;
+            uint8_t buf1[VECTOR_SIZE], buf2[VECTOR_SIZE];
+            uint8_t *src, *dst;
+            enum vector_op op;
+
+            fetch_registers(r1, r2);
+            src = vector_load(vm, vm->regfile[r1], buf1);
+            dst = vector_load(vm, vm->regfile[r2], buf2);
+
+            op = opcode == VADDB ? VECTOR_ADD : opcode == VMINUB ? VECTOR_MIN : VECTOR_MAX;
+            vector_apply(op, dst, src);
+            vector_store(vm, vm->regfile[r2], dst);
+        } break;
+
+        case VCMPEQB: {
+            enum vm_register r1, r2, r3;
+            uint8_t buf1[VECTOR_SIZE], buf2[VECTOR_SIZE];
+
+            fetch_registers(r1, r2);
+            fetch_register(r3);
+
+            vm->regfile[r3] = vector_cmpeq(vector_load(vm, vm->regfile[r2], buf2), vector_load(vm, vm->regfile[r1], buf1));
+        } break;
+
+        case VFINDB: {
+            enum vm_register r1, r2, r3;
+            uint8_t buf[VECTOR_SIZE];
+            int i;
+
+            fetch_registers(r1, r2);
+            fetch_register(r3);
+
+            i = vector_find(vector_load(vm, vm->regfile[r2], buf), vm->regfile[r1]);
+            vm->flags[ZF] = i < VECTOR_SIZE;
+            vm->regfile[r3] = i;
+        } break;
+
+        case CRC32C: {
+            enum vm_register r1, r2, r3, r4;
+            uint8_t *p;
+            uint32_t crc;
+
+            fetch_registers(r1, r2);
+            fetch_registers(r3, r4);
+
+            p = block_read(vm, vm->regfile[r1], vm->regfile[r2], vm->block_buf);
+            crc = crc32c_update((uint32_t) vm->regfile[r4] << 16 | vm->regfile[r3], p, vm->regfile[r2]);
+            vm->regfile[r3] = crc;
+            vm->regfile[r4] = crc >> 16;
+        } break;
+
+        case XXH32: {
+            enum vm_register r1, r2, r3, r4;
+            uint8_t *p;
+            uint32_t h;
+
+            fetch_registers(r1, r2);
+            fetch_registers(r3, r4);
+
+            p = block_read(vm, vm->regfile[r1], vm->regfile[r2], vm->block_buf);
+            h = xxh32_hash((uint32_t) vm->regfile[r4] << 16 | vm->regfile[r3], p, vm->regfile[r2]);
+            vm->regfile[r3] = h;
+            vm->regfile[r4] = h >> 16;
+        } break;
+
+        case CMP: {
+            enum vm_register r1, r2;
+            int16_t a, b, t;
+
+            fetch_registers(r1, r2);
+
+            a = vm->regfile[r2];
+            b = vm->regfile[r1];
+            t = a - b;
+
+            set_flags(vm, a, b, t);
+        } break;
+
+        case CMPI: {
+            enum vm_register r1;
+            int16_t a, b, t;
+
+            fetch_imm16(b);
+            fetch_register(r1);
+
+            a = vm->regfile[r1];
+            t = a - b;
+
+            set_flags(vm, a, b, t);
+        } break;
+
+        case CMPB: {
+            enum vm_register r1, r2;
+            int8_t a, b, t;
+
+            fetch_registers(r1, r2);
+
+            a = vm->regfile[r2];
+            b = vm->regfile[r1];
+            t = a - b;
+
+            set_flags(vm, a, b, t);
+        } break;
+
+        case CMPBI: {
+            enum vm_register r1;
+            int8_t a, b, t;
+
+            fetch_imm8(b);
+            fetch_register(r1);
+
+            a = vm->regfile[r1];
+            t = a - b;
+
+            set_flags(vm, a, b, t);
+        } break;
+
+        case JABS: {
+            uint16_t imm;
+
+            fetch_imm16(imm);
+            vm->pc = imm;
+        } break;
+
+        case JE: {
+            uint16_t imm;
+
+            fetch_imm16(imm);
+            if (vm->flags[ZF] == 1) {
+                vm->pc = imm;
+            }
+        } break;
+
+        case JNE: {
+            uint16_t imm;
+
+            fetch_imm16(imm);
+            if (vm->flags[ZF] == 0) {
+                vm->pc = imm;
+            }
+        } break;
+
+        case JG: {
+            uint16_t imm;
+
+            fetch_imm16(imm);
+            if (!(vm->flags[SF] ^ vm->flags[OF]) && !vm->flags[ZF]) {
+                vm->pc = imm;
+            }
+        } break;
+
+        case JGE: {
+            uint16_t imm;
+
+            fetch_imm16(imm);
+            if (!(vm->flags[SF] ^ vm->flags[OF])) {
+                vm->pc = imm;
+            }
+        } break;
+
+        case JL: {
+            uint16_t imm;
+
+            fetch_imm16(imm);
+            if (vm->flags[SF] ^ vm->flags[OF]) {
+                vm->pc = imm;
+            }
+        } break;
+
+        case JLE: {
+            uint16_t imm;
+
+            fetch_imm16(imm);
+            if ((vm->flags[SF] ^ vm->flags[OF]) || vm->flags[ZF]) {
+                vm->pc = imm;
+            }
+        } break;
+
+        case JA: {
+            uint16_t imm;
+
+            fetch_imm16(imm);
+            if (vm->flags[CF] && !vm->flags[ZF]) {
+                vm->pc = imm;
+            }
+        } break;
+
+        case JAE: {
+            uint16_t imm;
+
+            fetch_imm16(imm);
+            if (vm->flags[CF]) {
+                vm->pc = imm;
+            }
+        } break;
+
+        case JB: {
+            uint16_t imm;
+
+            fetch_imm16(imm);
+            if (!vm->flags[CF]) {
+                vm->pc = imm;
+            }
+        } break;
+
+        case JBE: {
+            uint16_t imm;
+
+            fetch_imm16(imm);
+            if (!vm->flags[CF] || vm->flags[ZF]) {
+                vm->pc = imm;
+            }
+        } break;
+
+        // Branches are relative to the end of the instruction, so code
+        // that only uses them runs at any load address.
+        case BR: {
+            int16_t rel;
+
+            fetch_imm16(rel);
+            vm->pc = (uint16_t) (vm->pc + rel);
+        } break;
+
+        case BRE: case BRNE: case BRG: case BRGE: case BRL:
+        case BRLE: case BRA: case BRAE: case BRB: case BRBE: {
+            int16_t rel;
+
+            fetch_imm16(rel);
+            if (condition(vm, opcode - BRE)) {
+                vm->pc = (uint16_t) (vm->pc + rel);
+            }
+        } break;
+
+        case BRS: {
+            int8_t rel;
+
+            fetch_imm8(rel);
+            vm->pc = (uint16_t) (vm->pc + rel);
+        } break;
+
+        case BRES: case BRNES: case BRGS: case BRGES: case BRLS:
+        case BRLES: case BRAS: case BRAES: case BRBS: case BRBES: {
+            int8_t rel;
+
+            fetch_imm8(rel);
+            if (condition(vm, opcode - BRES)) {
+                vm->pc = (uint16_t) (vm->pc + rel);
+            }
+        } break;
+
+        // Index past the end of the table takes the default target. The
+        // verifier checked the targets, but the guest may have changed the
+        // table since.
+        case JTAB: {
+            enum vm_register r1;
+            uint16_t table, i;
+
+            fetch_register(r1);
+            fetch_imm16(table);
+
+            i = vm->regfile[r1];
+            if (i < read_word(vm, table)) {
+                vm->pc = read_word(vm, table + 4 + 2 * i);
+            } else {
+                vm->pc = read_word(vm, table + 2);
+            }
+
+            if (!checked && vm->code_map[(uint16_t) vm->pc] != CODE_START) {
+                return EXEC_UNVERIFIED;
+            }
+        } break;
+
+        // Decrements the counter and branches back while it is nonzero.
+        // Flags are left alone so a test inside the body survives.
+        case LOOP: {
+            enum vm_register r1;
+            int16_t rel;
+
+            fetch_register(r1);
+            fetch_imm16(rel);
+
+            if (--vm->regfile[r1] != 0) {
+                vm->pc = (uint16_t) (vm->pc + rel);
+            }
+        } break;
+
+        case LOOPS: {
+            enum vm_register r1;
+            int8_t rel;
+
+            fetch_register(r1);
+            fetch_imm8(rel);
+
+            if (--vm->regfile[r1] != 0) {
+                vm->pc = (uint16_t) (vm->pc + rel);
+            }
+        } break;
+
+        case PUSH: {
+            enum vm_register r1;
+
+            fetch_register(r1);
+            stack_push(vm, vm->regfile[r1]);
+        } break;
+
+        case PUSHI: {
+            uint16_t imm;
+
+            fetch_imm16(imm);
+            stack_push(vm, imm);
+        } break;
+
+        case POP: {
+            enum vm_register r1;
+
+            fetch_register(r1);
+            vm->regfile[r1] = stack_pop(vm);
+        } break;
+
+        case PUSHM: {
+            uint16_t imm;
+
+            fetch_imm16(imm);
+            stack_push_mask(vm, imm);
+        } break;
+
+        case POPM: {
+            uint16_t imm;
+
+            fetch_imm16(imm);
+            stack_pop_mask(vm, imm);
+        } break;
+
+        case CALL: {
+            uint16_t imm;
+
+            fetch_imm16(imm);
+            stack_push(vm, vm->pc);
+            vm->pc = imm;
+        } break;
+
+        case CALLR: {
+            enum vm_register r1;
+
+            fetch_register(r1);
+            stack_push(vm, vm->pc);
+            vm->pc = vm->regfile[r1];
+
+            if (!checked && vm->code_map[(uint16_t) vm->pc] != CODE_START) {
+                return EXEC_UNVERIFIED;
+            }
+        } break;
+
+        case BSR: {
+            int16_t rel;
+
+            fetch_imm16(rel);
+            stack_push(vm, vm->pc);
+            vm->pc = (uint16_t) (vm->pc + rel);
+        } break;
+
+        case BSRS: {
+            int8_t rel;
+
+            fetch_imm8(rel);
+            stack_push(vm, vm->pc);
+            vm->pc = (uint16_t) (vm->pc + rel);
+        } break;
+
+        case RET:
+            vm->pc = stack_pop(vm);
+
+            if (!checked && vm->code_map[(uint16_t) vm->pc] != CODE_START) {
+                return EXEC_UNVERIFIED;
+            }
+            break;
+
+        // ENTER saves RBP, points it at the saved copy and reserves imm
+        // bytes of locals below it. LEAVE undoes all of that.
+        case ENTER: {
+            uint16_t imm;
+
+            fetch_imm16(imm);
+            stack_push(vm, vm->regfile[RBP]);
+            vm->regfile[RBP] = vm->regfile[RSP];
+            vm->regfile[RSP] -= imm;
+        } break;
+
+        case LEAVE:
+            vm->regfile[RSP] = vm->regfile[RBP];
+            vm->regfile[RBP] = stack_pop(vm);
+            break;
+
+        case BANK: {
+            enum vm_register r1;
+
+            fetch_register(r1);
+            if (vm->regfile[r1] >= BANK_COUNT) {
+                vm_log(vm, "invalid bank `%d` at ram[%d]", vm->regfile[r1], saved_pc);
+                return fault(vm, saved_pc);
+            }
+
+            bank_select(vm, vm->regfile[r1]);
+        } break;
+
+        // Enabling interrupts, also by IRET, lets a pending one in before
+        // the next instruction.
+        case EI:
+            vm->flags[IF] = 1;
+            clock_schedule(vm);
+            break;
+
+        case DI:
+            vm->flags[IF] = 0;
+            break;
+
+        // WAIT idles until an interrupt is pending. A running timer fires
+        // at once: idle time counts for the timer but not for the budget.
+        // Otherwise the host gets VM_WAITING. An interrupt that arrives
+        // while they are disabled is left pending and execution goes on
+        // after WAIT.
+        case WAIT:
+            if (vm->interrupts != 0) {
+                break;
+            }
+
+            if (vm->timer != NULL && vm->timer->reload != 0) {
+                clock_sync(vm);
+                vm->timer->left = 0;
+                clock_schedule(vm);
+                break;
+            }
+
+            return VM_WAITING;
+
+        case IRET:
+            flags_unpack(vm, stack_pop(vm));
+            vm->pc = stack_pop(vm);
+            clock_schedule(vm);
+
+            if (!checked && vm->code_map[(uint16_t) vm->pc] != CODE_START) {
+                return EXEC_UNVERIFIED;
+            }
+            if (checked && vm->verified && vm->code_map[(uint16_t) vm->pc] == CODE_START) {
+                return EXEC_VERIFIED;
+            }
+            break;
+
+        case SYSCALL:
+            fetch_imm8(vm->syscall_number);
+            vm->exit_pc = saved_pc;
+            return VM_SYSCALL;
+
+        default:
+            vm_log(vm, "unknown opcode `%02x` at ram[%d]", opcode, saved_pc);
+            return fault(vm, saved_pc);
+        }
+    }
+}
+
+#undef fetch_registers
+#undef fetch_register
+#undef fetch_condition
+#undef fetch_imm16
+#undef fetch_imm8
+
+// Runs the unchecked dispatch from verified code, then the checked one.
+// EXEC_VERIFIED is handed on to vm_execute, which starts over.
+static inline __attribute__((always_inline)) int vm_dispatch(struct vm *vm, int fixed, int counted)
+{
+    int status;
+
+    status = EXEC_UNVERIFIED;
+    if (vm->verified && vm->code_map[(uint16_t) vm->pc] == CODE_START) {
+        status = vm_exec(vm, 0, fixed, counted);
+    }
+    if (status == EXEC_UNVERIFIED) {
+        status = vm_exec(vm, 1, fixed, counted);
+    }
+
+    return status;
+}
+
+// One function per encoding and budget mode. With all the copies in one
+// function the compiler no longer keeps ram and pc in registers across the
+// dispatch loop.
+__attribute__((noinline)) int vm_execute_variable(struct vm *vm)
+{
+    return vm_dispatch(vm, 0, 0);
+}
+
+__attribute__((noinline)) int vm_execute_variable_counted(struct vm *vm)
+{
+    return vm_dispatch(vm, 0, 1);
+}
+
+__attribute__((noinline)) int vm_execute_fixed(struct vm *vm)
+{
+    return vm_dispatch(vm, 1, 0);
+}
+
+__attribute__((noinline)) int vm_execute_fixed_counted(struct vm *vm)
+{
+    return vm_dispatch(vm, 1, 1);
+}
+
+// Runs from pc until the program halts, faults, makes a system call or
+// uses up the budget. Verified code runs unchecked until it leaves the
+// verified instructions, the rest in checked mode. A run that resumes on
+// an instruction the verifier did not mark starts out checked.
+int vm_execute(struct vm *vm)
+{
+    int counted, status;
+
+    counted = vm->budget >= 0 || vm->timer != NULL || vm->interrupts != 0;
+    clock_schedule(vm);
+
+    // The verifier only follows the code reachable from the entry point,
+    // not the interrupt handlers. An interrupt drops into checked mode and
+    // its IRET comes back here to switch to the unchecked dispatch again.
+    // Looping out here rather than in vm_dispatch keeps the inlined copies
+    // fast.
+    do {
+        if (vm->encoding == ENCODING_FIXED) {
+            status = counted ? vm_execute_fixed_counted(vm) : vm_execute_fixed(vm);
+        } else {
+            status = counted ? vm_execute_variable_counted(vm) : vm_execute_variable(vm);
+        }
+    } while (status == EXEC_VERIFIED);
+
+    clock_sync(vm);
+
+    return status;
+}
+
+void vm_start(struct vm *vm)
+{
+    vm->budget = -1;
+    vm_execute(vm);
+    bus_halt(vm);
+}
+
+struct vm *vm_create(void)
+{
+    struct vm *vm;
+
+    vm = calloc(1, sizeof(*vm));
+    if (vm == NULL) {
+        return NULL;
+    }
+
+    // A zeroed instance is a machine without ram, at pc 0 with nothing
+    // mapped and bank 0 selected.
+    if (ram_init(vm) != 0) {
+        free(vm);
+        return NULL;
+    }
+
+    return vm;
+}
+
+void vm_destroy(struct vm *vm)
+{
+    if (vm == NULL) {
+        return;
+    }
+
+    // Output the guest has not flushed yet, as when a run stopped on the
+    // budget or a system call and was never resumed.
+    bus_halt(vm);
+
+    file_detach(&vm->file);
+    bank_reset(vm);
+    ram_free(vm);
+    free(vm);
+}
+
+void vm_set_log(struct vm *vm, void (*log)(void *arg, const char *msg), void *arg)
+{
+    vm->log = log;
+    vm->log_arg = arg;
+}
+
+int vm_attach_console(struct vm *vm, int fd)
+{
+    return console_attach(vm, &vm->console, fd);
+}
+
+int vm_attach_file(struct vm *vm, const char *path)
+{
+    file_detach(&vm->file);
+
+    return file_attach(vm, &vm->file, path);
+}
+
+int vm_attach_timer(struct vm *vm)
+{
+    return timer_attach(vm, &vm->timer_device);
+}
+
+int vm_attach_channel(struct vm *vm, int n, struct vm_channel *ch, int receive)
+{
+    if (n < 0 || n >= CHANNEL_COUNT) {
+        return -1;
+    }
+
+    if (!vm->channel_port_attached) {
+        if (channel_port_attach(vm, &vm->channel_port) != 0) {
+            return -1;
+        }
+        vm->channel_port_attached = 1;
+    }
+
+    vm->channel_port.channels[n] = ch;
+    if (receive) {
+        ch->receiver = vm;
+    }
+
+    return 0;
+}
+
+int vm_load(struct vm *vm, uint16_t addr, const void *image, int len,
+        enum vm_encoding enc)
+{
+    if (len < 0 || addr + len > RAM_CAP) {
+        vm_log(vm, "vm: image of %d bytes does not fit at ram[%d]", len, addr);
+        return -1;
+    }
+
+    if (len > 0) {
+        memcpy(vm->ram + addr, image, len);
+    }
+    vm->encoding = enc;
+    vm->pc = addr;
+
+    // An image that does not verify still runs, in checked mode.
+    verify_image(vm, addr);
+
+    return 0;
+}
+
+enum vm_status vm_run(struct vm *vm, long budget)
+{
+    enum vm_status status;
+
+    vm->interrupts |= __atomic_exchange_n(&vm->raised, 0, __ATOMIC_ACQUIRE);
+    if (__atomic_load_n(&vm->waiting, __ATOMIC_RELAXED)) {
+        if (vm->interrupts == 0) {
+            return VM_WAITING;
+        }
+        __atomic_store_n(&vm->waiting, 0, __ATOMIC_RELAXED);
+    }
+
+    vm->budget = budget;
+    for (;;) {
+        status = vm_execute(vm);
+        if (status != VM_WAITING) {
+            break;
+        }
+
+        // Whoever clears waiting after an interrupt was raised resumes the
+        // machine: this run if the interrupt got here first, else the host
+        // that vm_raise returned 1 to.
+        __atomic_store_n(&vm->waiting, 1, __ATOMIC_SEQ_CST);
+        if (__atomic_load_n(&vm->raised, __ATOMIC_SEQ_CST) == 0 ||
+                !__atomic_exchange_n(&vm->waiting, 0, __ATOMIC_SEQ_CST)) {
+            break;
+        }
+        vm->interrupts |= __atomic_exchange_n(&vm->raised, 0, __ATOMIC_ACQUIRE);
+    }
+
+    if (status == VM_HALTED || status == VM_FAULT) {
+        bus_halt(vm);
+    }
+
+    return status;
+}
+
+enum vm_status vm_step(struct vm *vm)
+{
+    return vm_run(vm, 1);
+}
+
+uint16_t vm_get_register(struct vm *vm, enum vm_register r)
+{
+    return vm->regfile[r];
+}
+
+void vm_set_register(struct vm *vm, enum vm_register r, uint16_t val)
+{
+    vm->regfile[r] = val;
+}
+
+uint16_t vm_get_pc(struct vm *vm)
+{
+    return vm->pc;
+}
+
+void vm_set_pc(struct vm *vm, uint16_t addr)
+{
+    vm->pc = addr;
+}
+
+void vm_read(struct vm *vm, uint16_t addr, void *buf, int len)
+{
+    bus_transfer(vm, addr, buf, len, 0);
+}
+
+void vm_write(struct vm *vm, uint16_t addr, const void *buf, int len)
+{
+    bus_transfer(vm, addr, (uint8_t *) buf, len, 1);
+}
+
+int vm_raise(struct vm *vm, int n)
+{
+    if (n < 0 || n >= INTERRUPT_COUNT) {
+        return -1;
+    }
+
+    __atomic_fetch_or(&vm->raised, 1 << n, __ATOMIC_SEQ_CST);
+
+    return __atomic_exchange_n(&vm->waiting, 0, __ATOMIC_SEQ_CST);
+}
+
+struct vm_channel *vm_channel_create(int slots, int size)
+{
+    struct vm_channel *ch;
+    int count;
+
+    if (slots <= 0 || size <= 0 || size > RAM_CAP) {
+        return NULL;
+    }
+
+    count = 1;
+    while (count < slots) {
+        count *= 2;
+    }
+
+    ch = calloc(1, sizeof(*ch));
+    if (ch == NULL) {
+        return NULL;
+    }
+
+    ch->mask = count - 1;
+    ch->size = size;
+    ch->stride = (sizeof(struct channel_slot) + size + 7) & ~7;
+    ch->slots = calloc(count, ch->stride);
+    if (ch->slots == NULL) {
+        free(ch);
+        return NULL;
+    }
+
+    for (int i = 0; i < count; ++i) {
+        channel_slot(ch, i)->seq = i;
+    }
+
+    return ch;
+}
+
+void vm_channel_destroy(struct vm_channel *ch)
+{
+    if (ch == NULL) {
+        return;
+    }
+
+    free(ch->slots);
+    free(ch);
+}
+
+int vm_channel_send(struct vm_channel *ch, const void *msg, int len)
+{
+    struct channel_slot *slot;
+
+    if (len < 0 || len > ch->size) {
+        return -1;
+    }
+
+    slot = channel_claim(ch);
+    if (slot == NULL) {
+        return -1;
+    }
+
+    memcpy(channel_data(slot), msg, len);
+
+    return channel_publish(ch, slot, len);
+}
+
+int vm_channel_receive(struct vm_channel *ch, void *buf, int len)
+{
+    struct channel_slot *slot;
+
+    slot = channel_peek(ch);
+    if (slot == NULL) {
+        return -1;
+    }
+
+    if (slot->len < len) {
+        len = slot->len;
+    }
+    memcpy(buf, channel_data(slot), len);
+    channel_release(ch, slot);
+
+    return len;
+}
+
+struct vm *vm_woken(struct vm *vm)
+{
+    struct channel_port *port = &vm->channel_port;
+    int n;
+
+    if (port->woken == 0) {
+        return NULL;
+    }
+
+    n = __builtin_ctz(port->woken);
+    port->woken &= ~(1 << n);
+
+    return port->channels[n]->receiver;
+}
+
+uint16_t vm_exit_pc(struct vm *vm)
+{
+    return vm->exit_pc;
+}
+
+uint8_t vm_syscall_number(struct vm *vm)
+{
+    return vm->syscall_number;
+}
+
+#ifdef TEST
+#include "tests/main.c"
+#endif
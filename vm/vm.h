@@ -1,84 +1,204 @@
+#ifndef VM_H
+#define VM_H
+
+#include <stdint.h>
+
+// Every instruction with the layout of its operands and its flow class, in
+// opcode order. The opcode enum, the layout, flow and name tables, the
+// encoder, the disassembler, the verifier and the test encoders are all
+// generated from this list. Layouts name the operands in encoding order,
+// see enum operand_layout; flow classes say where execution goes next, see
+// enum flow_class.
+#define VM_OPCODES(X) \
+    X(HALT, NONE, END) \
+    \
+    X(MOV, REG4_REG4, NEXT) \
+    X(MOVI, IMM16_REG8, NEXT) \
+    X(MOVB, REG4_REG4, NEXT) \
+    X(MOVBI, IMM8_REG8, NEXT) \
+    X(MOVZE, REG4_REG4, NEXT) \
+    X(MOVSE, REG4_REG4, NEXT) \
+    X(CMOV, COND_REG4_REG4, NEXT) \
+    X(SET, COND_REG8, NEXT) \
+    \
+    X(ST, REG4_REG4, NEXT) \
+    X(STI, REG8_IMM16, NEXT) \
+    X(STB, REG4_REG4, NEXT) \
+    X(STBI, REG8_IMM16, NEXT) \
+    X(LD, REG4_REG4, NEXT) \
+    X(LDI, IMM16_REG8, NEXT) \
+    X(LDB, REG4_REG4, NEXT) \
+    X(LDBI, IMM16_REG8, NEXT) \
+    X(STD, REG4_REG4_IMM16, NEXT) \
+    X(STBD, REG4_REG4_IMM16, NEXT) \
+    X(LDD, REG4_REG4_IMM16, NEXT) \
+    X(LDBD, REG4_REG4_IMM16, NEXT) \
+    X(STX, REG4_REG4_SCALE_REG4, NEXT) \
+    X(STBX, REG4_REG4_SCALE_REG4, NEXT) \
+    X(LDX, REG4_REG4_SCALE_REG4, NEXT) \
+    X(LDBX, REG4_REG4_SCALE_REG4, NEXT) \
+    X(BMOV, REG4_REG4_REG8, NEXT) \
+    X(BFILL, REG4_REG4_REG8, NEXT) \
+    X(BCMP, REG4_REG4_REG8, NEXT) \
+    \
+    X(SCANB, REG4_REG4_REG4_REG4, NEXT) \
+    X(MISMATCH, REG4_REG4_REG4_REG4, NEXT) \
+    X(STRNLEN, REG4_REG4_REG8, NEXT) \
+    \
+    X(ADD, REG4_REG4, NEXT) \
+    X(ADDI, IMM16_REG8, NEXT) \
+    X(ADDB, REG4_REG4, NEXT) \
+    X(ADDBI, IMM8_REG8, NEXT) \
+    X(SUB, REG4_REG4, NEXT) \
+    X(SUBI, IMM16_REG8, NEXT) \
+    X(SUBB, REG4_REG4, NEXT) \
+    X(SUBBI, IMM8_REG8, NEXT) \
+    \
+    X(ADDF, REG4_REG4, NEXT) \
+    X(ADDFI, IMM16_REG8, NEXT) \
+    X(ADDFB, REG4_REG4, NEXT) \
+    X(ADDFBI, IMM8_REG8, NEXT) \
+    X(SUBF, REG4_REG4, NEXT) \
+    X(SUBFI, IMM16_REG8, NEXT) \
+    X(SUBFB, REG4_REG4, NEXT) \
+    X(SUBFBI, IMM8_REG8, NEXT) \
+    X(ADC, REG4_REG4, NEXT) \
+    X(ADCI, IMM16_REG8, NEXT) \
+    X(ADCB, REG4_REG4, NEXT) \
+    X(ADCBI, IMM8_REG8, NEXT) \
+    X(SBB, REG4_REG4, NEXT) \
+    X(SBBI, IMM16_REG8, NEXT) \
+    X(SBBB, REG4_REG4, NEXT) \
+    X(SBBBI, IMM8_REG8, NEXT) \
+    \
+    X(MUL, REG4_REG4, NEXT) \
+    X(MULI, IMM16_REG8, NEXT) \
+    X(MULB, REG4_REG4, NEXT) \
+    X(MULBI, IMM8_REG8, NEXT) \
+    X(MULH, REG4_REG4, NEXT) \
+    X(MULHS, REG4_REG4, NEXT) \
+    X(DIV, REG4_REG4, NEXT) \
+    X(DIVI, IMM16_REG8, NEXT) \
+    X(DIVS, REG4_REG4, NEXT) \
+    X(DIVSI, IMM16_REG8, NEXT) \
+    X(MOD, REG4_REG4, NEXT) \
+    X(MODI, IMM16_REG8, NEXT) \
+    X(MODS, REG4_REG4, NEXT) \
+    X(MODSI, IMM16_REG8, NEXT) \
+    \
+    X(NOT, REG8, NEXT) \
+    X(NOTB, REG8, NEXT) \
+    X(AND, REG4_REG4, NEXT) \
+    X(ANDI, IMM16_REG8, NEXT) \
+    X(ANDB, REG4_REG4, NEXT) \
+    X(ANDBI, IMM8_REG8, NEXT) \
+    X(OR, REG4_REG4, NEXT) \
+    X(ORI, IMM16_REG8, NEXT) \
+    X(ORB, REG4_REG4, NEXT) \
+    X(ORBI, IMM8_REG8, NEXT) \
+    X(XOR, REG4_REG4, NEXT) \
+    X(XORI, IMM16_REG8, NEXT) \
+    X(XORB, REG4_REG4, NEXT) \
+    X(XORBI, IMM8_REG8, NEXT) \
+    \
+    X(SHL, REG4_REG4, NEXT) \
+    X(SHLI, IMM8_REG8, NEXT) \
+    X(SHLB, REG4_REG4, NEXT) \
+    X(SHLBI, IMM8_REG8, NEXT) \
+    X(SHR, REG4_REG4, NEXT) \
+    X(SHRI, IMM8_REG8, NEXT) \
+    X(SHRB, REG4_REG4, NEXT) \
+    X(SHRBI, IMM8_REG8, NEXT) \
+    X(SHRA, REG4_REG4, NEXT) \
+    X(SHRAI, IMM8_REG8, NEXT) \
+    X(SHRAB, REG4_REG4, NEXT) \
+    X(SHRABI, IMM8_REG8, NEXT) \
+    \
+    X(PADDB, REG4_REG4, NEXT) \
+    X(PCMPEQB, REG4_REG4, NEXT) \
+    X(PMINUB, REG4_REG4, NEXT) \
+    X(PMAXUB, REG4_REG4, NEXT) \
+    X(VADDB, REG4_REG4, NEXT) \
+    X(VMINUB, REG4_REG4, NEXT) \
+    X(VMAXUB, REG4_REG4, NEXT) \
+    X(VCMPEQB, REG4_REG4_REG8, NEXT) \
+    X(VFINDB, REG4_REG4_REG8, NEXT) \
+    \
+    X(CRC32C, REG4_REG4_REG4_REG4, NEXT) \
+    X(XXH32, REG4_REG4_REG4_REG4, NEXT) \
+    \
+    X(CMP, REG4_REG4, NEXT) \
+    X(CMPI, IMM16_REG8, NEXT) \
+    X(CMPB, REG4_REG4, NEXT) \
+    X(CMPBI, IMM8_REG8, NEXT) \
+    \
+    X(JABS, IMM16, JUMP) \
+    X(JE, IMM16, BRANCH) \
+    X(JNE, IMM16, BRANCH) \
+    X(JG, IMM16, BRANCH) \
+    X(JGE, IMM16, BRANCH) \
+    X(JL, IMM16, BRANCH) \
+    X(JLE, IMM16, BRANCH) \
+    X(JA, IMM16, BRANCH) \
+    X(JAE, IMM16, BRANCH) \
+    X(JB, IMM16, BRANCH) \
+    X(JBE, IMM16, BRANCH) \
+    \
+    X(BR, IMM16, JUMP_REL) \
+    X(BRE, IMM16, BRANCH_REL) \
+    X(BRNE, IMM16, BRANCH_REL) \
+    X(BRG, IMM16, BRANCH_REL) \
+    X(BRGE, IMM16, BRANCH_REL) \
+    X(BRL, IMM16, BRANCH_REL) \
+    X(BRLE, IMM16, BRANCH_REL) \
+    X(BRA, IMM16, BRANCH_REL) \
+    X(BRAE, IMM16, BRANCH_REL) \
+    X(BRB, IMM16, BRANCH_REL) \
+    X(BRBE, IMM16, BRANCH_REL) \
+    \
+    X(BRS, IMM8, JUMP_REL) \
+    X(BRES, IMM8, BRANCH_REL) \
+    X(BRNES, IMM8, BRANCH_REL) \
+    X(BRGS, IMM8, BRANCH_REL) \
+    X(BRGES, IMM8, BRANCH_REL) \
+    X(BRLS, IMM8, BRANCH_REL) \
+    X(BRLES, IMM8, BRANCH_REL) \
+    X(BRAS, IMM8, BRANCH_REL) \
+    X(BRAES, IMM8, BRANCH_REL) \
+    X(BRBS, IMM8, BRANCH_REL) \
+    X(BRBES, IMM8, BRANCH_REL) \
+    \
+    X(JTAB, REG8_IMM16, TABLE) \
+    \
+    X(LOOP, REG8_IMM16, LOOP) \
+    X(LOOPS, REG8_IMM8, LOOP) \
+    \
+    X(PUSH, REG8, NEXT) \
+    X(PUSHI, IMM16, NEXT) \
+    X(POP, REG8, NEXT) \
+    X(PUSHM, IMM16, NEXT) \
+    X(POPM, IMM16, NEXT) \
+    X(CALL, IMM16, CALL) \
+    X(CALLR, REG8, NEXT) \
+    X(BSR, IMM16, CALL_REL) \
+    X(BSRS, IMM8, CALL_REL) \
+    X(RET, NONE, END) \
+    X(ENTER, IMM16, NEXT) \
+    X(LEAVE, NONE, NEXT) \
+    \
+    X(BANK, REG8, NEXT) \
+    \
+    X(EI, NONE, NEXT) \
+    X(DI, NONE, NEXT) \
+    X(IRET, NONE, END) \
+    X(WAIT, NONE, NEXT) \
+    \
+    X(SYSCALL, IMM8, NEXT)
+
 enum vm_opcode {
-    HALT,
-
-    MOV,   // reg4 reg4
-    MOVI,  // imm16 reg8
-    MOVB,  // reg4 reg4
-    MOVBI, // imm8 reg8
-    MOVZE, // reg4 reg4
-    MOVSE, // reg4 reg4
-
-    ST,   // reg4 reg4
-    STI,  // reg8 imm16
-    STB,  // reg4 reg4
-    STBI, // reg8 imm16
-    LD,   // reg4 reg4
-    LDI,  // imm16 reg8
-    LDB,  // reg4 reg4
-    LDBI, // imm16 reg8
-
-    ADD,   // reg4 reg4
-    ADDI,  // imm16 reg8
-    ADDB,  // reg4 reg4
-    ADDBI, // imm8 reg8
-    SUB,   // reg4 reg4
-    SUBI,  // imm16 reg8
-    SUBB,  // reg4 reg4
-    SUBBI, // imm8 reg8
-
-    NOT,   // reg8
-    NOTB,  // reg8
-    AND,   // reg4 reg4
-    ANDI,  // imm16 reg8
-    ANDB,  // reg4 reg4
-    ANDBI, // imm8 reg8
-    OR,    // reg4 reg4
-    ORI,   // imm16 reg8
-    ORB,   // reg4 reg4
-    ORBI,  // imm8 reg8
-    XOR,   // reg4 reg4
-    XORI,  // imm16 reg8
-    XORB,  // reg4 reg4
-    XORBI, // imm8 reg8
-
-    SHL,    // reg4 reg4
-    SHLI,   // imm8 reg8
-    SHLB,   // reg4 reg4
-    SHLBI,  // imm8 reg8
-    SHR,    // reg4 reg4
-    SHRI,   // imm8 reg8
-    SHRB,   // reg4 reg4
-    SHRBI,  // imm8 reg8
-    SHRA,   // reg4 reg4
-    SHRAI,  // imm8 reg8
-    SHRAB,  // reg4 reg4
-    SHRABI, // imm8 reg8
-
-    CMP,   // reg4 reg4
-    CMPI,  // imm16 reg8
-    CMPB,  // reg4 reg4
-    CMPBI, // imm8 reg8
-
-    JABS, // imm16
-    JE,   // imm16
-    JNE,  // imm16
-    JG,   // imm16
-    JGE,  // imm16
-    JL,   // imm16
-    JLE,  // imm16
-    JA,   // imm16
-    JAE,  // imm16
-    JB,   // imm16
-    JBE,  // imm16
-
-    PUSH,  // reg8
-    PUSHI, // imm16
-    POP,   // reg8
-    CALL,  // imm16
-    CALLR, // reg8
-    RET,
-
-    /*SYSCALL*/
+#define X(name, layout, NEXT) name,
+    VM_OPCODES(X)
+#undef X
 
     VM_OPCODE_COUNT
 };
@@ -104,3 +224,221 @@ enum vm_register {
 
     VM_REGISTER_COUNT
 };
+
+// How an image is encoded. In the variable encoding an instruction is its
+// opcode byte followed by its operands in the order of its layout in
+// VM_OPCODES (enum operand_layout in vm.c): two register or scale nibbles
+// share a byte, first one in the high nibble, a register on its own and
+// conditions take a byte, immediates one or two bytes, little endian. In
+// the fixed encoding every instruction is one little endian 32-bit word
+// at a 4-byte aligned address: the opcode, two register nibbles (first
+// operand in the high one) and an imm16. Immediates and conditions go in
+// the imm16 field. Nibbles past the second go in its low byte, which is
+// free because no instruction has both.
+enum vm_encoding {
+    ENCODING_VARIABLE,
+    ENCODING_FIXED
+};
+
+// Branch conditions, in the same order as the Jcc opcodes.
+enum vm_condition {
+    COND_E,
+    COND_NE,
+    COND_G,
+    COND_GE,
+    COND_L,
+    COND_LE,
+    COND_A,
+    COND_AE,
+    COND_B,
+    COND_BE,
+
+    VM_CONDITION_COUNT
+};
+
+// Console: the guest fills a ring buffer in ram and publishes it by
+// storing its producer index to CONSOLE_TAIL. The host drains the ring
+// with one write when it fills up, when the guest stores to
+// CONSOLE_FLUSH and when the machine halts. Indices are free running,
+// the free space is CONSOLE_RING_SIZE - (tail - head).
+enum vm_console {
+    CONSOLE_RING = 0xfd00,
+    CONSOLE_RING_SIZE = 256,
+
+    CONSOLE_PORT = 0xfe00,
+    CONSOLE_HEAD = CONSOLE_PORT,      // word, read only
+    CONSOLE_TAIL = CONSOLE_PORT + 2,  // word
+    CONSOLE_FLUSH = CONSOLE_PORT + 4  // byte, write only
+};
+
+// File window: FILE_WINDOW_SIZE bytes of a host file appear read only at
+// FILE_WINDOW. FILE_OFFSET selects which part, in 256 byte pages, so the
+// window can be moved anywhere in files of up to 1 TiB. Bytes past the end
+// of the file read as zero.
+enum vm_file {
+    FILE_WINDOW = 0xc000,
+    FILE_WINDOW_SIZE = 0x2000,
+
+    FILE_PORT = 0xfc00,
+    FILE_OFFSET = FILE_PORT,   // two words, low first
+    FILE_SIZE = FILE_PORT + 4  // three words, low first, read only
+};
+
+// Banked memory: BANK selects which of BANK_COUNT banks of BANK_SIZE bytes
+// shows up at BANK_WINDOW. Bank 0 is the ram that is there anyway, the
+// others start out zeroed.
+enum vm_bank {
+    BANK_WINDOW = 0x8000,
+    BANK_SIZE = 0x4000,
+    BANK_COUNT = 256
+};
+
+// Timer: storing to TIMER_RELOAD arms it to raise INTERRUPT_TIMER every
+// TIMER_RELOAD instructions, storing 0 stops it. TIMER_COUNT is how many
+// instructions are left until it fires next.
+enum vm_timer {
+    TIMER_PORT = 0xfb00,
+    TIMER_RELOAD = TIMER_PORT,    // word
+    TIMER_COUNT = TIMER_PORT + 2  // word, read only
+};
+
+// Channels: bounded message queues between machines, which the host
+// attaches to endpoints 0 to CHANNEL_COUNT - 1. Storing n to CHANNEL_SEND
+// sends the CHANNEL_LEN bytes at CHANNEL_ADDR as a message on endpoint n.
+// Storing n to CHANNEL_RECEIVE copies the oldest message of endpoint n to
+// CHANNEL_ADDR, at most CHANNEL_LEN bytes of it, and sets CHANNEL_LEN to the
+// number copied. CHANNEL_STATUS is 1 if that worked and 0 if the queue was
+// full or empty, the message too long, the endpoint unattached or, for a
+// receive, not attached to receive. A message raises INTERRUPT_CHANNEL on
+// the machine that receives from the channel.
+enum vm_channel_port {
+    CHANNEL_PORT = 0xf900,
+    CHANNEL_ADDR = CHANNEL_PORT,         // word
+    CHANNEL_LEN = CHANNEL_PORT + 2,      // word
+    CHANNEL_SEND = CHANNEL_PORT + 4,     // byte, write only
+    CHANNEL_RECEIVE = CHANNEL_PORT + 5,  // byte, write only
+    CHANNEL_STATUS = CHANNEL_PORT + 6,   // byte, read only
+
+    CHANNEL_COUNT = 4
+};
+
+// Interrupts are taken between instructions while EI has enabled them.
+// The machine pushes pc and then the flags, disables interrupts and jumps
+// to the address in the vector of the interrupt, the word at
+// INTERRUPT_VECTORS + 2 * n in ram. IRET pops the flags and pc back. The
+// flags word has ZF, SF, CF, OF and the interrupt enable in bits 0 to 4.
+// Lower numbers go first when several are pending.
+enum vm_interrupt {
+    INTERRUPT_TIMER,
+    INTERRUPT_CHANNEL,
+
+    INTERRUPT_COUNT = 8,
+    INTERRUPT_VECTORS = 0xfaf0
+};
+
+// The V* instructions work on VECTOR_SIZE consecutive bytes of memory at the
+// addresses held in their registers.
+enum {
+    VECTOR_SIZE = 16
+};
+
+// Why vm_run returned. After VM_FAULT and VM_SYSCALL vm_exit_pc is the
+// address of the instruction. A system call leaves pc on the instruction
+// after it, so the host services it and calls vm_run again; the number is
+// in vm_syscall_number, arguments and results go through registers.
+// VM_WAITING means the guest executed WAIT with nothing to wake it but the
+// host: vm_run keeps returning it until vm_raise.
+enum vm_status {
+    VM_HALTED,
+    VM_BUDGET,
+    VM_FAULT,
+    VM_SYSCALL,
+    VM_WAITING
+};
+
+#define VM_API __attribute__((visibility("default")))
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// A machine with its own ram, registers, banks and devices. Any number of
+// them can exist and they share nothing, so different threads may drive
+// different machines. The calls on one machine must come from one thread
+// at a time, vm_raise aside.
+struct vm;
+
+// A new machine has zeroed ram and registers, pc 0 and nothing mapped.
+// vm_create returns NULL with errno set when the host is out of memory.
+VM_API struct vm *vm_create(void);
+VM_API void vm_destroy(struct vm *vm);
+
+// The machine reports what went wrong, why an image did not verify, what
+// faulted or which device call failed, by calling log with one line of
+// text and no newline. Until the host sets a callback it says nothing.
+VM_API void vm_set_log(struct vm *vm, void (*log)(void *arg, const char *msg), void *arg);
+
+VM_API int vm_attach_console(struct vm *vm, int fd);
+// Attaching a file again replaces the one attached before.
+VM_API int vm_attach_file(struct vm *vm, const char *path);
+VM_API int vm_attach_timer(struct vm *vm);
+
+// A queue of at most slots messages, rounded up to a power of two, of up to
+// size bytes each. Any number of threads and machines may send, one
+// receives: the machine it is attached to with receive set, or the host.
+struct vm_channel;
+
+VM_API struct vm_channel *vm_channel_create(int slots, int size);
+VM_API void vm_channel_destroy(struct vm_channel *ch);
+
+// Attaches ch to endpoint n of vm. The channel has to outlive the machine,
+// and a receiving machine every send on the channel.
+VM_API int vm_attach_channel(struct vm *vm, int n, struct vm_channel *ch, int receive);
+
+// Both return -1 when the queue is full or empty. vm_channel_send returns 1
+// instead of 0 when the message woke the receiving machine from WAIT, and
+// the caller is the one to run it again, as with vm_raise.
+// vm_channel_receive copies at most len bytes and returns how many.
+VM_API int vm_channel_send(struct vm_channel *ch, const void *msg, int len);
+VM_API int vm_channel_receive(struct vm_channel *ch, void *buf, int len);
+
+// Copies len bytes of image to ram at addr, points pc at it and verifies
+// it from there.
+VM_API int vm_load(struct vm *vm, uint16_t addr, const void *image, int len,
+        enum vm_encoding enc);
+
+// Runs at most budget instructions, without limit if budget is negative.
+// VM_BUDGET leaves pc on the next instruction, vm_step runs just that one.
+VM_API enum vm_status vm_run(struct vm *vm, long budget);
+VM_API enum vm_status vm_step(struct vm *vm);
+
+VM_API uint16_t vm_get_register(struct vm *vm, enum vm_register r);
+VM_API void vm_set_register(struct vm *vm, enum vm_register r, uint16_t val);
+VM_API uint16_t vm_get_pc(struct vm *vm);
+VM_API void vm_set_pc(struct vm *vm, uint16_t addr);
+
+// Memory as the guest sees it, devices included. Accesses wrap at the end
+// of ram.
+VM_API void vm_read(struct vm *vm, uint16_t addr, void *buf, int len);
+VM_API void vm_write(struct vm *vm, uint16_t addr, const void *buf, int len);
+
+// Raises interrupt n, which the machine takes on its next vm_run. Unlike
+// the rest of the API it may be called from any thread, also while the
+// machine runs. Returns 1 if that woke the machine from WAIT: its vm_run
+// returned or is about to return VM_WAITING, and the caller is the one to
+// run it again once it has.
+VM_API int vm_raise(struct vm *vm, int n);
+
+// The receivers that sends by the guest of vm woke from WAIT, one per call
+// and NULL once there are none left. The host that ran vm is the one to run
+// them again.
+VM_API struct vm *vm_woken(struct vm *vm);
+
+VM_API uint16_t vm_exit_pc(struct vm *vm);
+VM_API uint8_t vm_syscall_number(struct vm *vm);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif